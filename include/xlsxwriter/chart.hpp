@@ -74,6 +74,7 @@
 #include <stdint.h>
 #include <string.h>
 
+#include <atomic>
 #include <memory>
 #include <vector>
 #include "xmlwriter.hpp"
@@ -84,6 +85,19 @@ namespace xlsxwriter {
 
 struct val_axis_args;
 
+/*
+ * A recorded part of the chart XML that is the same for every chart with
+ * the same settings, apart from the axis ids. The ids are written between
+ * the literal parts, as given by the slots.
+ */
+struct chart_fragment {
+    std::vector<std::string> literals;
+    std::vector<uint8_t> slots;
+    bool cacheable;
+};
+
+typedef std::shared_ptr<const chart_fragment> chart_fragment_ptr;
+
 #define LXW_CHART_NUM_FORMAT_LEN 128
 
 /** Available chart types . */
@@ -199,10 +213,40 @@ enum lxw_marker_types {
 struct series_data_point {
     bool is_string;
     double number;
-    std::string* string;
+    std::string string;
     bool no_data;
 };
 
+/*
+ * The cached data of a chart series range, stored by column so that a range
+ * with many points doesn't need an object per point. Points without a string
+ * are written as numbers.
+ */
+struct series_data_cache {
+    void clear();
+    void reserve(uint32_t num_points);
+    void add_number(double number);
+    void add_string(const std::string& string);
+    void add_missing();
+
+    uint32_t size() const { return (uint32_t) numbers.size(); }
+    bool empty() const { return numbers.empty(); }
+    bool is_missing(uint32_t index) const { return missing[index]; }
+    bool has_string(uint32_t index) const {
+        return !string_offsets.empty()
+               && string_offsets[index + 1] != string_offsets[index];
+    }
+
+    std::vector<double> numbers;
+    std::vector<bool> missing;
+
+    /* The string data of all the points, and the offset of each point's
+     * string followed by the end offset. The offsets are only added once a
+     * point has a string. */
+    std::string string_data;
+    std::vector<size_t> string_offsets;
+};
+
 struct series_range {
     series_range();
     std::string formula;
@@ -213,9 +257,15 @@ struct series_range {
     lxw_col_t last_col;
     bool ignore_cache;
 
+    /* The cached data was set by the caller, or for testing, and isn't read
+     * from the worksheet. */
+    bool user_data;
+
     bool has_string_cache;
-    uint16_t num_data_points;
-    std::vector<std::shared_ptr<series_data_point>> data_cache;
+
+    /* The cached data, which is shared by the ranges of all the charts that
+     * refer to the same cells. */
+    std::shared_ptr<series_data_cache> data_cache;
 };
 
 typedef std::shared_ptr<series_range> series_range_ptr;
@@ -321,6 +371,41 @@ public:
     void set_values(const std::string& sheetname, lxw_row_t first_row, lxw_col_t first_col,
                     lxw_row_t last_row, lxw_col_t last_col);
 
+    /**
+     * @brief Set the cached data of a series "values" range from an array.
+     *
+     * @param data       The values of the points in the range.
+     * @param num_points The number of values.
+     *
+     * Excel charts store a copy of the data in their range alongside the
+     * range formula. By default the copy is read from the worksheet cells
+     * when the file is written. The `%set_values_data()` function sets it
+     * from an array instead, which is faster for large series and also works
+     * with `constant_memory` worksheets, where the cells can't be read back:
+     *
+     * @code
+     *     chart_series_ptr series = chart->add_series("", "=Sheet1!$B$1:$B$1000");
+     *
+     *     series->set_values_data(values, 1000);
+     * @endcode
+     *
+     * The data is copied. The range formula must still be set and should
+     * refer to cells with the same values. `NAN` values are written as
+     * points without data.
+     */
+    void set_values_data(const double *data, uint32_t num_points);
+
+    /**
+     * @brief Set the cached data of a series "categories" range from an array.
+     *
+     * @param data       The values or strings of the points in the range.
+     * @param num_points The number of points.
+     *
+     * The categories equivalent of `set_values_data()`.
+     */
+    void set_categories_data(const double *data, uint32_t num_points);
+    void set_categories_data(const std::string *data, uint32_t num_points);
+
     /**
      * @brief Set the name of a chart series range.
      *
@@ -690,6 +775,8 @@ public:
     void set_hole_size(uint8_t size);
 
     static void set_range(const series_range_ptr& range, const std::string &sheetname, lxw_row_t first_row, lxw_col_t first_col, lxw_row_t last_row, lxw_col_t last_col);
+    static void set_range_data(const series_range_ptr& range, const double *data, uint32_t num_points);
+    static void set_range_data(const series_range_ptr& range, const std::string *data, uint32_t num_points);
 
     void set_y2_axis(const std::shared_ptr<chart_axis> &axis);
 
@@ -698,6 +785,12 @@ protected:
     uint8_t type;
     uint8_t subtype;
     uint16_t series_index;
+    bool initialized;
+
+    /* The fragment being recorded and the position it started at in the
+     * recording buffer. */
+    chart_fragment *recording;
+    size_t recording_offset;
 
     virtual void write_chart_type(bool) = 0;
     virtual void write_plot_area();
@@ -734,7 +827,7 @@ protected:
     uint32_t axis_id_3;
     uint32_t axis_id_4;
 
-    bool in_use;
+    std::atomic<bool> in_use;
     bool is_scatter;
     bool cat_has_num_fmt;
 
@@ -782,12 +875,12 @@ protected:
     void _write_a_p_rich(const std::string &name);
     void _write_a_lst_style();
     void _write_a_body_pr(chart_title *title);
-    void _write_pt_count(uint16_t num_data_points);
+    void _write_pt_count(uint32_t num_data_points);
     void _write_v_num(double number);
     void _write_v_str(const std::string &str);
-    void _write_pt(uint16_t index, const std::shared_ptr<series_data_point>& data_point);
+    void _write_pt(const series_data_cache& cache, uint32_t index);
     void _write_f(const std::string &formula);
-    void _write_num_pt(uint16_t index, const std::shared_ptr<series_data_point>& data_point);
+    void _write_num_pt(const series_data_cache& cache, uint32_t index);
     void _write_format_code();
     void _write_num_cache(const series_range_ptr&range);
     void _write_str_cache(const series_range_ptr& range);
@@ -859,6 +952,12 @@ protected:
     void _xml_declaration();
     void _write_print_settings();
     void _write_chart();
+    void _write_chart_head();
+    void _write_chart_tail();
+    void _write_axes();
+    bool _axes_fragment_key(std::string& key);
+    void _write_fragment(const std::string& key, void (chart::*writer)());
+    bool _record_slot(uint8_t type, uint32_t axis_id);
     void _write_bar_dir(const std::string &type);
 };
 
@@ -932,7 +1031,7 @@ protected:
 };
 
 int XLSXWRITER_EXPORT chart_add_data_cache(series_range *range, uint8_t *data,
-                             uint16_t rows, uint8_t cols, uint8_t col);
+                             uint32_t rows, uint8_t cols, uint8_t col);
 
 
 } // namespace xlsxwriter
@@ -99,6 +99,15 @@ typedef enum lxw_error {
     /** Couldn't read image dimensions or DPI. */
     LXW_ERROR_IMAGE_DIMENSIONS,
 
+    /** Workbook close was cancelled before the xlsx file was complete. */
+    LXW_ERROR_CLOSE_CANCELLED,
+
+    /** Workbook save() isn't supported in constant_memory mode. */
+    LXW_ERROR_SAVE_CONSTANT_MEMORY,
+
+    /** Couldn't open an inserted image file to add it to the xlsx file. */
+    LXW_ERROR_IMAGE_FILE_OPEN,
+
     LXW_MAX_ERRNO
 } lxw_error;
 
@@ -161,6 +170,7 @@ enum lxw_custom_property_types {
 
 #define LXW_UINT32_T_LENGTH       sizeof("4294967296")
 #define LXW_FILENAME_LENGTH       128
+#define LXW_BUFFER_SIZE           4096
 #define LXW_IGNORE                1
 
 #define LXW_SCHEMA_MS        "http://schemas.microsoft.com/office/2006/relationships"
@@ -62,6 +62,7 @@ struct XLSXWRITER_EXPORT drawing_object {
     uint32_t width;
     uint32_t height;
     uint8_t shape;
+    uint16_t rel_index;
     std::string description;
     std::string url;
     std::string tip;
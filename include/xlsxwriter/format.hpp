@@ -67,6 +67,7 @@
 #include "common.hpp"
 
 #include <memory>
+#include <mutex>
 
 namespace xlsxwriter {
 
@@ -331,6 +332,15 @@ struct lxw_font {
         memset(this, 0, sizeof(lxw_font));
     }
 
+    lxw_font(const lxw_font& other) {
+        memcpy(this, &other, sizeof(lxw_font));
+    }
+
+    lxw_font& operator=(const lxw_font& other) {
+        memcpy(this, &other, sizeof(lxw_font));
+        return *this;
+    }
+
     char font_name[LXW_FORMAT_FIELD_LEN];
     uint16_t font_size;
     uint8_t bold;
@@ -358,6 +368,15 @@ struct lxw_border {
         memset(this, 0, sizeof(lxw_border));
     }
 
+    lxw_border(const lxw_border& other) {
+        memcpy(this, &other, sizeof(lxw_border));
+    }
+
+    lxw_border& operator=(const lxw_border& other) {
+        memcpy(this, &other, sizeof(lxw_border));
+        return *this;
+    }
+
     uint8_t bottom;
     uint8_t diag_border;
     uint8_t diag_type;
@@ -378,10 +397,20 @@ typedef lxw_border* lxw_border_ptr;
 /*
  * Struct to represent the fill component of a format.
  */
-struct lxw_fill {    
+struct lxw_fill {
     lxw_fill() {
         memset(this, 0, sizeof(lxw_fill));
     }
+
+    lxw_fill(const lxw_fill& other) {
+        memcpy(this, &other, sizeof(lxw_fill));
+    }
+
+    lxw_fill& operator=(const lxw_fill& other) {
+        memcpy(this, &other, sizeof(lxw_fill));
+        return *this;
+    }
+
     lxw_color_t fg_color;
     lxw_color_t bg_color;
     uint8_t pattern;
@@ -390,6 +419,16 @@ struct lxw_fill {
 
 typedef lxw_fill* lxw_fill_ptr;
 
+/* The font, border and fill keys are hashed and compared byte for byte. */
+template <>
+struct hash_key_traits<lxw_font> : hash_key_bytes<lxw_font> {};
+
+template <>
+struct hash_key_traits<lxw_border> : hash_key_bytes<lxw_border> {};
+
+template <>
+struct hash_key_traits<lxw_fill> : hash_key_bytes<lxw_fill> {};
+
 class styles;
 class workbook;
 
@@ -420,12 +459,13 @@ class workbook;
 class XLSXWRITER_EXPORT format {
     friend class styles;
     friend class workbook;
+    friend class format_spec;
 public:
     format();
     int32_t get_xf_index();
-    lxw_font *get_font_key();
-    lxw_border *get_border_key();
-    lxw_fill *get_fill_key();
+    lxw_font get_font_key() const;
+    lxw_border get_border_key() const;
+    lxw_fill get_fill_key() const;
 
     /**
      * @brief Set the font used in the cell.
@@ -1125,6 +1165,10 @@ private:
     hash_table<format*, format*> *xf_format_indices;
     uint16_t *num_xf_formats;
 
+    /* Workbook lock for the xf_format_indices, since worksheets can be
+     * written and saved from several threads. */
+    std::mutex *xf_format_mutex;
+
     int32_t xf_index;
     int32_t dxf_index;
 
@@ -1198,6 +1242,71 @@ private:
 
 typedef format* format_ptr;
 
+/**
+ * @brief An immutable snapshot of the properties of a format.
+ *
+ * A format_spec is a value type that captures the cell formatting
+ * properties of a format, together with a precomputed hash. It is used with
+ * workbook::intern_format() to get a shared workbook format for a set of
+ * properties without creating a new format object each time:
+ *
+ * @code
+ *     xlsxwriter::format scratch;
+ *
+ *     for (row = 0; row < 1000; row++) {
+ *         scratch.set_bg_color(row % 2 ? LXW_COLOR_GRAY : LXW_COLOR_WHITE);
+ *
+ *         format *cell_format = workbook->intern_format(format_spec(scratch));
+ *         worksheet->write_number(row, 0, row, cell_format);
+ *     }
+ * @endcode
+ *
+ * The scratch format can be a local object since it isn't added to the
+ * workbook.
+ */
+class XLSXWRITER_EXPORT format_spec {
+    friend class workbook;
+public:
+    /**
+     * @brief Create a spec with the default format properties.
+     */
+    format_spec();
+
+    /**
+     * @brief Create a spec from the current properties of a format.
+     *
+     * @param format The format to take the properties from. Later changes
+     *               to the format don't affect the spec.
+     */
+    format_spec(const format& format);
+
+    format_spec(const format_spec& other);
+    format_spec& operator=(const format_spec& other);
+
+    /** The precomputed hash of the format properties. */
+    uint64_t hash() const { return hash_value; }
+
+    bool operator==(const format_spec& other) const;
+    bool operator!=(const format_spec& other) const { return !(*this == other); }
+
+private:
+    void _init(const format& format);
+
+    format properties;
+    uint64_t hash_value;
+};
+
+template <>
+struct hash_key_traits<format_spec> {
+    static uint64_t hash(const format_spec& key) {
+        return key.hash();
+    }
+
+    static bool equal(const format_spec& key1, const format_spec& key2) {
+        return key1 == key2;
+    }
+};
+
 } // namespace xlsxwriter
 
 #endif /* __xlsxwriter::format_H__ */
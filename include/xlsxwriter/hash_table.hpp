@@ -10,61 +10,186 @@
 #ifndef __LXW_HASH_TABLE_H__
 #define __LXW_HASH_TABLE_H__
 
+#include <stdint.h>
+#include <string.h>
+
 #include "common.hpp"
-#include <list>
-#ifndef INT16_MAX
-#define INT16_MAX (32767)
-#endif
-#include <unordered_map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace xlsxwriter {
+
+/* 64 bit FNV-1a hash of a block of data. Pass the hash of the previous
+ * blocks to continue it over data that is read in parts. */
+uint64_t lxw_hash_bytes(const void *data, size_t data_len,
+                        uint64_t hash = 14695981039346656037ULL);
 
 /*
- * LXW_HASH table element struct.
- *
- * The hash elements contain pointers to allow them to be stored in
- * lists in the the hash table buckets and also pointers to track the
- * insertion order in a separate list.
+ * Hash and equality functions for the hash_table keys. Pointer keys refer to
+ * key structs, such as the format keys used for the XF indices, that are
+ * compared byte for byte.
  */
-struct lxw_hash_element {
-    void *key;
-    void *value;
-};
+template <class K>
+struct hash_key_traits;
 
-size_t _generate_hash_key(void *data, size_t data_len, size_t num_buckets);
+/*
+ * Byte for byte hash and equality for key structs held by value. The structs
+ * must clear and copy their padding, see lxw_font for example.
+ */
+template <class T>
+struct hash_key_bytes {
+    static uint64_t hash(const T& key) {
+        return lxw_hash_bytes(&key, sizeof(T));
+    }
+
+    static bool equal(const T& key1, const T& key2) {
+        return memcmp(&key1, &key2, sizeof(T)) == 0;
+    }
+};
 
 template <class T>
-size_t generate_hash_key(const T* data)
-{
-    return _generate_hash_key((void*)data, sizeof(T), INT16_MAX);
-}
-size_t generate_hash_key(const std::string& data);
+struct hash_key_traits<T*> {
+    static uint64_t hash(const T *key) {
+        return lxw_hash_bytes(key, sizeof(T));
+    }
 
-namespace xlsxwriter {
+    static bool equal(const T *key1, const T *key2) {
+        return memcmp(key1, key2, sizeof(T)) == 0;
+    }
+};
+
+template <>
+struct hash_key_traits<std::string> {
+    static uint64_t hash(const std::string& key) {
+        return lxw_hash_bytes(key.data(), key.size());
+    }
+
+    static bool equal(const std::string& key1, const std::string& key2) {
+        return key1 == key2;
+    }
+};
 
-template <class K, class V>
+/*
+ * Insertion ordered hash table.
+ *
+ * The key/value pairs are stored contiguously in insertion order, which is
+ * the order that the style elements are written out in, and are indexed by
+ * an open addressing table of slots using linear probing. Each slot holds
+ * the position of a pair plus one, or 0 if the slot is empty. The full hash
+ * of each key is kept so that probes only compare keys when the hashes
+ * match and so that the slots can be rebuilt without rehashing the keys.
+ *
+ * Pointers returned by find() and insert() are invalidated by the next
+ * insert().
+ */
+template <class K, class V, class Traits = hash_key_traits<K> >
 class hash_table {
 public:
+    typedef std::pair<K, V> value_type;
+    typedef typename std::vector<value_type>::iterator iterator;
+    typedef typename std::vector<value_type>::const_iterator const_iterator;
+
+    hash_table() : mask(0) {}
+
+    /*
+     * Find a key in the table. Returns NULL if it isn't found.
+     */
+    value_type *find(const K& key) {
+        uint64_t hash;
+        size_t slot;
+        size_t i;
+
+        if (entries.empty())
+            return NULL;
+
+        hash = Traits::hash(key);
+
+        for (slot = hash & mask; slots[slot]; slot = (slot + 1) & mask) {
+            i = slots[slot] - 1;
+
+            if (hashes[i] == hash && Traits::equal(entries[i].first, key))
+                return &entries[i];
+        }
+
+        return NULL;
+    }
+
+    /*
+     * Insert a key/value pair if the key isn't already in the table. Returns
+     * the new or existing pair and whether the insertion took place.
+     */
+    std::pair<value_type*, bool> insert(const K& key, const V& val) {
+        uint64_t hash = Traits::hash(key);
+        size_t slot;
+        size_t i;
+
+        /* Keep the load factor at or below 1/2. */
+        if ((entries.size() + 1) * 2 > slots.size())
+            _grow();
 
-    std::pair<std::pair<K, V>, bool > exists(const K& key) {
-        size_t keyhash = generate_hash_key(key);
-        auto it = storage.find(keyhash);
-        if (it != storage.end())
-            return std::make_pair(it->second, true);
-        else
-            return std::make_pair(std::pair<K, V>(), false);
+        for (slot = hash & mask; slots[slot]; slot = (slot + 1) & mask) {
+            i = slots[slot] - 1;
+
+            if (hashes[i] == hash && Traits::equal(entries[i].first, key))
+                return std::make_pair(&entries[i], false);
+        }
+
+        entries.push_back(value_type(key, val));
+        hashes.push_back(hash);
+        slots[slot] = (uint32_t) entries.size();
+
+        return std::make_pair(&entries.back(), true);
+    }
+
+    /* Access the pairs in insertion order. */
+    value_type& operator[](size_t i) { return entries[i]; }
+    const value_type& operator[](size_t i) const { return entries[i]; }
+
+    iterator begin() { return entries.begin(); }
+    iterator end() { return entries.end(); }
+    const_iterator begin() const { return entries.begin(); }
+    const_iterator end() const { return entries.end(); }
+
+    /* The insertion order position of a pair returned by find() or insert(). */
+    size_t index(const value_type *entry) const { return entry - &entries[0]; }
+
+    size_t size() const { return entries.size(); }
+    bool empty() const { return entries.empty(); }
+
+    void clear() {
+        entries.clear();
+        hashes.clear();
+        slots.clear();
+        mask = 0;
     }
 
-    std::pair<std::pair<K, V>, bool > insert(const K& key, const V& val) {
-        size_t keyhash = generate_hash_key(key);
-        auto res = storage.insert(std::make_pair(keyhash, std::make_pair(key, val)));
-        if (res.second)
-            order_list.push_back(std::make_pair(key, val));
-        return std::make_pair(res.first->second, res.second);
+private:
+    /*
+     * Double the number of slots and re-index the stored pairs.
+     */
+    void _grow() {
+        size_t num_slots = slots.empty() ? 16 : slots.size() * 2;
+        size_t slot;
+        size_t i;
+
+        slots.assign(num_slots, 0);
+        mask = num_slots - 1;
+
+        for (i = 0; i < entries.size(); i++) {
+            for (slot = hashes[i] & mask; slots[slot]; slot = (slot + 1) & mask)
+                ;
+
+            slots[slot] = (uint32_t) (i + 1);
+        }
     }
 
-    std::list<std::pair<K, V>> order_list;
-    std::unordered_map<size_t, std::pair<K, V>> storage;
+    std::vector<value_type> entries;
+    std::vector<uint64_t> hashes;
+    std::vector<uint32_t> slots;
+    size_t mask;
 };
 
-}
+} // namespace xlsxwriter
 
 #endif /* __LXW_HASH_TABLE_H__ */
@@ -13,8 +13,13 @@
 #include <xlsxwriter/third_party/zip.h>
 
 #include <string>
+#include <vector>
+#include <atomic>
+#include <functional>
 
 #include <xlsxwriter/common.hpp>
+#include <xlsxwriter/spool.hpp>
+#include <xlsxwriter/part_cache.hpp>
 #include <xlsxwriter/workbook.hpp>
 #include <xlsxwriter/worksheet.hpp>
 #include <xlsxwriter/shared_strings.hpp>
@@ -43,13 +48,25 @@ namespace xlsxwriter {
 class no_zip_file_exception : public std::exception {
 };
 
+/*
+ * A file in the package, such as a chart, that can be assembled and
+ * compressed independently of the others.
+ */
+struct package_part {
+    std::string filename;
+    std::function<void(spool&)> assemble;
+    part_cache_member_ptr member;
+    uint8_t error;
+};
+
 /*
  * Struct to represent a packager.
  */
 class XLSXWRITER_EXPORT packager {
     friend class xlsxwriter::workbook;
 public:
-    packager(const std::string& filename, const std::string& tmpdir = std::string());
+    packager(const std::string& filename, const std::string& tmpdir = std::string(),
+             size_t spool_threshold = LXW_SPOOL_THRESHOLD);
 
     uint8_t create_package();
 
@@ -64,10 +81,21 @@ private:
     std::string filename;
     //std::string buffer;
     std::string tmpdir;
+    size_t spool_threshold;
+    part_cache *cache;
+    uint16_t threads;
 
     uint16_t chart_count;
     uint16_t drawing_count;
 
+    const std::atomic<bool> *cancelled;
+    std::function<void(uint32_t, uint32_t)> progress;
+    uint32_t parts_written;
+    uint32_t parts_total;
+
+    uint32_t _count_parts();
+    uint8_t _create_package();
+
     uint8_t _write_workbook_file();
     uint8_t _write_worksheet_files();
     uint8_t _write_image_files();
@@ -79,6 +107,22 @@ private:
     uint8_t _write_core_file();
     uint8_t _write_custom_file();
     uint8_t _add_file_to_zip(FILE *file, const char *filename);
+    uint8_t _add_file_to_zip(spool& part, const char *filename);
+    uint8_t _add_buffer_to_zip(const char *data, size_t size,
+                               const char *filename);
+    uint8_t _add_cached_file_to_zip(spool& part, const char *filename);
+    uint8_t _add_retained_file_to_zip(spool& part, const char *filename,
+                                      part_cache_member_ptr& saved_part);
+    uint8_t _add_member_to_zip(const char *filename,
+                               const part_cache_member_ptr& member);
+    uint8_t _add_parts_to_zip(std::vector<package_part>& parts,
+                              uint16_t max_threads);
+    uint8_t _add_raw_file_to_zip(const char *filename,
+                                 const unsigned char *data, size_t size,
+                                 uint32_t crc, size_t uncompressed_size);
+    uint8_t _open_zip_member(const char *filename, bool raw = false);
+    uint8_t _close_zip_member(bool raw = false, uint32_t crc = 0,
+                              size_t uncompressed_size = 0);
     uint8_t _write_worksheet_rels_file();
     uint8_t _write_drawing_rels_file();
     uint8_t _write_content_types_file();
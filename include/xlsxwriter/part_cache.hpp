@@ -0,0 +1,144 @@
+/*
+ * libxlsxwriter
+ *
+ * Copyright 2014-2016, John McNamara, jmcnamara@cpan.org. See LICENSE.txt.
+ *
+ * part_cache - A process wide cache of deflated xlsx package parts, keyed
+ *              by the content of the uncompressed part.
+ *
+ */
+#ifndef __LXW_PART_CACHE_HPP__
+#define __LXW_PART_CACHE_HPP__
+
+#include <stdint.h>
+
+#include "common.hpp"
+#include "spool.hpp"
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/* Default memory budget, in bytes, for the deflated parts in the cache. */
+#define LXW_PART_CACHE_SIZE (16 * 1024 * 1024)
+
+/* Size of the chunks that spooled parts are read and deflated in. */
+#define LXW_PART_CACHE_BUFFER_SIZE 0x8000
+
+namespace xlsxwriter {
+
+/*
+ * A deflated part. The data is a raw deflate stream that can be added to a
+ * zip file as is, together with the CRC32 and size of the original data.
+ */
+struct part_cache_member {
+    uint64_t hash;
+    uint32_t crc32;
+    size_t uncompressed_size;
+    std::vector<unsigned char> deflated;
+};
+
+typedef std::shared_ptr<const part_cache_member> part_cache_member_ptr;
+
+/**
+ * @brief Cache of compressed xlsx package parts.
+ *
+ * Parts such as styles.xml, [Content_Types].xml or _rels/.rels are often
+ * byte for byte identical between workbooks created by the same program.
+ * When a workbook is created with the `use_part_cache` option the packager
+ * looks each part up in the process wide cache and, on a hit, copies the
+ * previously deflated data into the zip file instead of compressing the part
+ * again.
+ *
+ * The original data of each part is kept with the deflated data, and a part
+ * is only found in the cache if the data is the same byte for byte, so that
+ * parts with colliding hashes can't be mixed up between workbooks.
+ *
+ * The cache holds at most max_size() bytes of original and deflated data and
+ * evicts the least recently used parts first. It is safe to use from several
+ * threads.
+ */
+class XLSXWRITER_EXPORT part_cache {
+public:
+    part_cache(size_t max_size = LXW_PART_CACHE_SIZE);
+
+    /**
+     * @brief Get the cache shared by all workbooks in the process.
+     */
+    static part_cache& global();
+
+    /**
+     * @brief Get the deflated form of a part.
+     *
+     * @param data The uncompressed part data.
+     * @param size The size of the data.
+     *
+     * @return The cached member, or a newly deflated one on a miss. NULL if
+     *         the data couldn't be compressed.
+     */
+    part_cache_member_ptr get(const char *data, size_t size);
+
+    /**
+     * @brief Set the memory budget for the cache, evicting parts if required.
+     *
+     * @param max_size Maximum size in bytes of the cached original and
+     *                 deflated data. A size of 0 disables caching.
+     */
+    void set_max_size(size_t max_size);
+    size_t max_size();
+
+    /** Remove all the cached parts. The counters aren't reset. */
+    void clear();
+
+    /** Number of bytes of original and deflated data held in the cache. */
+    size_t size();
+
+    /** Number of parts held in the cache. */
+    size_t count();
+
+    /** Number of lookups found in the cache. */
+    uint64_t hits();
+
+    /** Number of lookups that had to compress the part. */
+    uint64_t misses();
+
+    /** Number of parts evicted to stay within the memory budget. */
+    uint64_t evictions();
+
+    /**
+     * @brief Deflate a part without adding it to a cache.
+     */
+    static part_cache_member_ptr compress(const char *data, size_t size);
+    static part_cache_member_ptr compress(spool& part);
+
+private:
+    /* A cached part and the data it was deflated from. */
+    struct entry {
+        part_cache_member_ptr member;
+        std::vector<char> data;
+
+        size_t size() const { return member->deflated.size() + data.size(); }
+    };
+
+    part_cache(const part_cache&);
+    part_cache& operator=(const part_cache&);
+
+    static part_cache_member_ptr _deflate(const char *data, size_t size,
+                                          uint64_t hash, uint32_t crc);
+    void _evict(size_t max_size);
+
+    std::mutex mutex;
+    std::list<entry> lru;
+    std::unordered_map<uint64_t, std::list<entry>::iterator> index;
+    size_t max_bytes;
+    size_t used_bytes;
+    uint64_t hit_count;
+    uint64_t miss_count;
+    uint64_t eviction_count;
+};
+
+} // namespace xlsxwriter
+
+#endif /* __LXW_PART_CACHE_HPP__ */
@@ -15,50 +15,190 @@
 
 #include "common.hpp"
 #include "xmlwriter.hpp"
+#include "part_cache.hpp"
+#include "spool.hpp"
 
-#include <unordered_set>
+#include <memory>
+#include <mutex>
+#include <string>
 #include <vector>
 
+/* Maximum length in bytes of a worksheet string. */
+#define LXW_STR_MAX 32767
+
+/* Size of the blocks that the shared strings are stored in. Must be at least
+ * LXW_STR_MAX. */
+#define LXW_SST_BLOCK_SIZE (64 * 1024)
+
+/* Index of an sst_handle that doesn't refer to a string. */
+#define LXW_SST_INVALID_INDEX UINT32_MAX
+
+/* The number of shards in a concurrent table is 1 << LXW_SST_SHARD_BITS. */
+#define LXW_SST_SHARD_BITS 4
+
 namespace xlsxwriter {
 
+class packager;
+
 /*
- * Elements of the SST table. They contain pointers to allow them to
- * be stored in a RB tree and also pointers to track the insertion order
- * in a separate list.
+ * A string stored in the SST arena, similar to a C++17 std::string_view.
+ * The data isn't NUL terminated.
  */
-struct XLSXWRITER_EXPORT sst_element {
-    uint32_t index;
-    std::string string;
+struct XLSXWRITER_EXPORT sst_string_ref {
+    const char *data;
+    uint32_t length;
+
+    /* Low 32 bits of the string hash, used to skip most string compares. */
+    uint32_t hash;
 
-    static bool equals( const std::shared_ptr<sst_element>& lhs, const std::shared_ptr<sst_element>& rhs );
+    std::string str() const { return std::string(data, length); }
 };
 
-typedef std::shared_ptr<sst_element> sst_element_ptr;
+/*
+ * A string stored in the spool of an on disk SST.
+ */
+struct sst_disk_ref {
+    uint64_t offset;
+    uint32_t length;
 
+    /* Low 32 bits of the string hash, used to skip most string reads. */
+    uint32_t hash;
+};
+
+/**
+ * @brief A handle to a string interned with workbook::intern_string().
+ *
+ * The handle can be written with worksheet::write_string() without hashing
+ * the string again.
+ */
+struct XLSXWRITER_EXPORT sst_handle {
+    sst_handle() : index(LXW_SST_INVALID_INDEX) {}
+    explicit sst_handle(uint32_t index) : index(index) {}
+
+    /** Check if the handle refers to a string. */
+    bool valid() const { return index != LXW_SST_INVALID_INDEX; }
 
-struct sst_equal
-{
-    bool operator()(const sst_element_ptr& a, const sst_element_ptr& b) const { return sst_element::equals(a, b); }
+    uint32_t index;
 };
 
-class packager;
+/*
+ * A part of the string table with its own arena, index and lock. The strings
+ * of a concurrent table are spread over several shards by hash so that
+ * threads writing different strings rarely wait for each other.
+ *
+ * The strings of an on disk shard are appended to a spool instead of the
+ * arena and only their offsets are kept in memory.
+ */
+struct sst_shard {
+    sst_shard();
 
-struct sst_hash_by_string {
-    inline size_t operator()(const sst_element_ptr& element) const
-    {
-        return std::hash<std::string>()(element->string);
-    }
+    uint32_t intern(const std::string& string, uint32_t hash);
+    uint32_t size() const;
+    std::string get(uint32_t index);
+    const char *_store_string(const std::string& string);
+    bool _equal(uint32_t index, const std::string& string, uint32_t hash);
+    void _grow();
+
+    std::mutex mutex;
+    uint32_t string_count;
+
+    /* The unique strings in insertion order. The string data is copied into
+     * fixed size blocks so that it never moves. */
+    std::vector<sst_string_ref> strings;
+    std::vector<std::unique_ptr<char[]> > blocks;
+    size_t block_used;
+
+    /* The unique strings of an on disk shard in insertion order, and the
+     * spool that holds their data. */
+    std::vector<sst_disk_ref> disk_strings;
+    std::unique_ptr<spool> disk;
+    std::string buffer;
+
+    /* Open addressing index of the strings. Each slot holds a string index
+     * plus one, or 0 if it is empty. */
+    std::vector<uint32_t> slots;
+    size_t mask;
+
+    /* Position of each string in sharedStrings.xml for a renumbered table,
+     * or LXW_SST_INVALID_INDEX if no cell uses it, and the number of cells
+     * that use it. */
+    std::vector<uint32_t> final_index;
+    std::vector<uint32_t> uses;
+
+    /* The final_index of each string from the previous numbering. */
+    std::vector<uint32_t> saved_final_index;
 };
 
 /*
  * Struct to represent a sst.
+ *
+ * The string ids stored in the cells are (shard index << shard_bits) | shard.
+ * A table that isn't concurrent has a single shard, so the ids are the
+ * positions of the strings in sharedStrings.xml.
+ *
+ * A concurrent table can be used from several threads at once. Since the
+ * order that strings are first added in depends on the thread timing, the
+ * strings are renumbered when the workbook is saved in the order that the
+ * cells use them, by worksheet, row and column. This keeps the output the
+ * same from run to run.
+ *
+ * A table ordered by frequency is also renumbered when the workbook is saved,
+ * with the strings used by the most cells first, so that the indices that
+ * are repeated most often in the worksheets are the shortest. Strings used by
+ * the same number of cells stay in the order that the cells use them.
+ *
+ * A table with strings that were interned in advance is renumbered too, in
+ * the order that the strings were added, so that strings that no cell uses
+ * are left out.
+ *
+ * An on disk table keeps the string data in a spool per shard, which spills
+ * to a tmpfile once it exceeds the spool threshold. Only the offset, length
+ * and hash of each string are held in memory, so a table with many millions
+ * of unique strings needs about 24 bytes per string. Strings with matching
+ * hashes are read back to compare them.
  */
 class XLSXWRITER_EXPORT sst : public xmlwriter {
     friend class packager;
 public:
-    sst_element *get_sst_index(const std::string& string);
+    sst(bool concurrent = false, bool by_frequency = false,
+        bool on_disk = false, const std::string& tmpdir = std::string(),
+        size_t spool_threshold = LXW_SPOOL_THRESHOLD);
+
+    uint32_t get_sst_index(const std::string& string);
+    uint32_t intern(const std::string& string);
+    bool has_string(uint32_t index);
+    void add_reference(uint32_t index);
+    std::string get_string(uint32_t index);
+    uint8_t error();
     void assemble_xml_file();
 
+    /* Functions used by the workbook to number the strings of a concurrent
+     * or frequency ordered table before it is written. */
+    bool is_renumbered() const { return renumbered; }
+    void drop_unused_strings();
+    void clear_order();
+    void add_to_order(uint32_t index);
+    void finalize();
+
+    /* Check if a string has moved since the previous numbering, so that
+     * the worksheets that use it have to be written again. */
+    bool final_index_changed(uint32_t index) const {
+        const sst_shard *shard = shards[index & shard_mask].get();
+        uint32_t local_index = index >> shard_bits;
+
+        return local_index >= shard->saved_final_index.size()
+               || shard->saved_final_index[local_index]
+                  != shard->final_index[local_index];
+    }
+
+    /* Position of a string in sharedStrings.xml, from its cell id. */
+    uint32_t get_final_index(uint32_t index) const {
+        if (!renumbered)
+            return index;
+
+        return shards[index & shard_mask]->final_index[index >> shard_bits];
+    }
+
     /* Declarations required for unit testing. */
 
     void _xml_declaration();
@@ -68,9 +208,25 @@ public:
 private:
 
     uint32_t unique_count;
-    std::unordered_set<sst_element_ptr, sst_hash_by_string, sst_equal> strings;
-    std::vector<sst_element_ptr> order_list;
 
+    bool concurrent;
+    bool by_frequency;
+    bool on_disk;
+    bool renumbered;
+    uint32_t shard_bits;
+    uint32_t shard_mask;
+    std::vector<std::unique_ptr<sst_shard> > shards;
+
+    /* The ids of the strings written to sharedStrings.xml, in order. Only
+     * used by a renumbered table. */
+    std::vector<uint32_t> order;
+
+    /* The compressed table from the last workbook::save(). It is reused
+     * while string_count is unchanged. */
+    part_cache_member_ptr saved_part;
+    uint32_t saved_string_count;
+
+    sst_shard *_get_shard(uint32_t index, uint32_t *local_index);
     void _write_t(const std::string &string);
     void _write_si(const std::string &string);
     void _write_sst();
@@ -0,0 +1,74 @@
+/*
+ * libxlsxwriter
+ *
+ * Copyright 2014-2016, John McNamara, jmcnamara@cpan.org. See LICENSE.txt.
+ *
+ * spool - A memory backed output buffer for the XML parts of the xlsx
+ *         package that only spills to a tmpfile when it grows too large.
+ *
+ */
+#ifndef __LXW_SPOOL_HPP__
+#define __LXW_SPOOL_HPP__
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "common.hpp"
+
+#include <string>
+
+/* Default size, in bytes, that a part can grow to before it is spilled to a
+ * tmpfile. */
+#define LXW_SPOOL_THRESHOLD (4 * 1024 * 1024)
+
+namespace xlsxwriter {
+
+/*
+ * Class to represent a spooled XML part. Data is appended to an in memory
+ * buffer until it exceeds the threshold, at which point the buffer is
+ * flushed to a tmpfile in tmpdir and all subsequent writes go to the file.
+ * A threshold of 0 writes straight to a tmpfile, like lxw_tmpfile().
+ *
+ * Data can be read back while the spool is still being written to. The next
+ * write after a read appends to the end of the data again.
+ */
+class XLSXWRITER_EXPORT spool {
+public:
+    spool(const std::string& tmpdir = std::string(),
+          size_t threshold = LXW_SPOOL_THRESHOLD);
+    ~spool();
+
+    void write(const char *data, size_t size);
+    void write(const std::string& data);
+    void print(const char *format, ...);
+
+    void rewind();
+    size_t read(char *buffer, size_t size);
+    size_t read_at(size_t offset, char *buffer, size_t size);
+
+    bool in_memory() const;
+    const char *data() const;
+    size_t size() const;
+    uint8_t error() const;
+
+private:
+    spool(const spool&);
+    spool& operator=(const spool&);
+
+    uint8_t _spill();
+
+    std::string tmpdir;
+    size_t threshold;
+    std::string buffer;
+    FILE *file;
+    size_t length;
+    size_t read_offset;
+    bool reading;
+    uint8_t err;
+};
+
+typedef std::shared_ptr<spool> spool_ptr;
+
+} // namespace xlsxwriter
+
+#endif /* __LXW_SPOOL_HPP__ */
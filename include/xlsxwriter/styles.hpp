@@ -64,7 +64,13 @@ private:
     std::vector<format_ptr> xf_formats;
     std::vector<format_ptr> dxf_formats;
 
-    void _write_num_fmt(uint16_t num_fmt_id, char* format_code);
+    /* The workbook tables of unique style elements, in index order. */
+    const hash_table<lxw_font, format_ptr> *fonts;
+    const hash_table<lxw_border, format_ptr> *borders;
+    const hash_table<lxw_fill, format_ptr> *fills;
+    const hash_table<std::string, uint16_t> *num_formats;
+
+    void _write_num_fmt(uint16_t num_fmt_id, const std::string& format_code);
     void _write_num_fmts();
     void _write_font_color_rgb(int32_t rgb);
     uint8_t _has_alignment(const format_ptr &format);
@@ -12,20 +12,14 @@
 #include <stdint.h>
 
 #include "common.hpp"
-#include "xmlwriter.hpp"
 
 namespace xlsxwriter {
 
-class packager;
-/*
- * Struct to represent a theme.
- */
-class XLSXWRITER_EXPORT theme : public xmlwriter {
-    friend class packager;
-public:
-    void xml_declaration();
-    void assemble_xml_file();
-};
+/* The pre-deflated theme1.xml part in theme_deflated.cpp, see gen_theme.cpp. */
+extern const unsigned char theme_deflated[];
+extern const size_t theme_deflated_size;
+extern const size_t theme_uncompressed_size;
+extern const uint32_t theme_crc32;
 
 /* Declarations required for unit testing. */
 #ifdef TESTING
@@ -49,11 +49,16 @@
 #include "chart.hpp"
 #include "shared_strings.hpp"
 #include "hash_table.hpp"
+#include "part_cache.hpp"
 #include "common.hpp"
 
 #include <map>
 #include <set>
 #include <unordered_set>
+#include <atomic>
+#include <functional>
+#include <future>
+#include <mutex>
 
 #define LXW_DEFINED_NAME_LENGTH 128
 
@@ -153,13 +158,58 @@ struct doc_properties {
  *   specify an alternative location using the `tempdir` option.
  */
 struct XLSXWRITER_EXPORT workbook_options {
-    workbook_options() : constant_memory(false) {}
+    workbook_options() : constant_memory(false), spool_threshold(LXW_SPOOL_THRESHOLD),
+                         use_part_cache(false), concurrent_strings(false),
+                         order_strings_by_frequency(false),
+                         disk_shared_strings(false), package_threads(1) {}
 
     /** Optimize the workbook to use constant memory for worksheets */
     bool constant_memory;
 
     /** Directory to use for the temporary files created by libxlsxwriter. */
     std::string tmpdir;
+
+    /** Size in bytes up to which each file in the xlsx package is assembled
+     *  in memory before it is spilled to a temporary file. */
+    size_t spool_threshold;
+
+    /** Reuse the compressed form of package files that are identical to
+     *  ones written earlier in the process. See xlsxwriter::part_cache. */
+    bool use_part_cache;
+
+    /** Allow strings to be written to different worksheets from several
+     *  threads at once. See @ref ww_mem_threads. */
+    bool concurrent_strings;
+
+    /** Number the shared strings with the most used first, to reduce the
+     *  size of the worksheet files. */
+    bool order_strings_by_frequency;
+
+    /** Keep the data of the shared strings in temporary files instead of
+     *  memory. See @ref ww_mem_disk_strings. */
+    bool disk_shared_strings;
+
+    /** Number of threads used to assemble and compress the chart and drawing
+     *  files. The default, 1, writes them on the closing thread and 0 uses
+     *  one thread per processor. */
+    uint16_t package_threads;
+};
+
+/**
+ * @brief Options for the asynchronous workbook close.
+ *
+ * Optional parameters used with workbook::close_async().
+ */
+struct XLSXWRITER_EXPORT close_options {
+
+    /** Executor used to run the close. It is passed a task to run, for
+     *  example on a thread pool. If it isn't set the close runs on a new
+     *  library owned thread. */
+    std::function<void(const std::function<void()>&)> executor;
+
+    /** Called from the closing thread after each file in the xlsx package
+     *  is written, with the number of files written and the total. */
+    std::function<void(uint32_t parts_written, uint32_t parts_total)> progress;
 };
 
 class packager;
@@ -170,8 +220,12 @@ class packager;
  * The members of the xlsxwriter::workbook struct aren't modified directly. Instead
  * the workbook properties are set by calling the functions shown in
  * workbook.h.
+ *
+ * Different worksheets can be written from different threads, see
+ * @ref ww_mem_threads.
  */
-class XLSXWRITER_EXPORT workbook : public xmlwriter {
+class XLSXWRITER_EXPORT workbook : public xmlwriter,
+                                   public std::enable_shared_from_this<workbook> {
     friend class packager;
 
 public:
@@ -207,6 +261,39 @@ public:
      *   accessible to your application, or doesn't contain enough space, you can
      *   specify an alternative location using the `tempdir` option.*
      *
+     * - `spool_threshold`: The sub-files of the XLSX package are assembled in
+     *   memory and only written to a temporary file in `tmpdir` once they grow
+     *   beyond this many bytes. The default is 4MB. Set it to 0 to always use
+     *   temporary files.
+     *
+     * - `use_part_cache`: Look up each file in the xlsx package in the process
+     *   wide xlsxwriter::part_cache and copy the compressed data of an
+     *   identical file from an earlier workbook instead of compressing it
+     *   again. This helps programs that create many similar workbooks. The
+     *   cache size is set with `part_cache::global().set_max_size()`.
+     *
+     * - `concurrent_strings`: Use a shared string table that can be updated
+     *   from several threads at once, for example by threads that each fill
+     *   in a different worksheet. The strings are numbered by the order that
+     *   the worksheets, rows and columns use them when the file is written,
+     *   so the output doesn't depend on the thread timing. It is ignored in
+     *   `constant_memory` mode, where the strings are written inline. See
+     *   @ref ww_mem_threads.
+     *
+     * - `order_strings_by_frequency`: Number the shared strings by how many
+     *   cells use them, most used first, when the file is written. Every
+     *   string cell refers to its string by number, so this gives the most
+     *   repeated strings the shortest numbers and reduces the size of the
+     *   worksheet files. Strings used by the same number of cells are
+     *   numbered in worksheet, row and column order. It is ignored in
+     *   `constant_memory` mode.
+     *
+     * - `disk_shared_strings`: Append each new shared string to a temporary
+     *   file in `tmpdir`, once more than `spool_threshold` bytes of strings
+     *   have been added, and only keep the position of the strings in
+     *   memory. This is slower but bounds the memory used by workbooks with
+     *   many millions of unique strings. See @ref ww_mem_disk_strings.
+     *
      * See @ref working_with_memory for more details.
      *
      */
@@ -284,6 +371,46 @@ public:
      */
     format* add_format();
 
+    /**
+     * @brief Get the workbook format for a set of format properties.
+     *
+     * @param spec The format properties. See format_spec.
+     *
+     * @return A format owned by the workbook.
+     *
+     * The `%intern_format()` function returns the same format for every
+     * identical spec, creating it the first time the spec is seen. This
+     * avoids creating a new format object for each cell when formats are
+     * computed per cell, for example when coloring cells by value. Looking up
+     * an existing spec doesn't allocate memory.
+     *
+     * The returned format shouldn't be modified since it is shared by all
+     * the cells that use the same spec.
+     */
+    format* intern_format(const format_spec& spec);
+
+    /**
+     * @brief Add a string to the workbook shared string table in advance.
+     *
+     * @param string The string to intern.
+     *
+     * @return A handle to write the string with worksheet::write_string().
+     *
+     * The `%intern_string()` function adds a string to the shared string
+     * table, or finds it if it is already there, and returns a handle to it.
+     * Writing the handle to a cell doesn't need to hash the string again.
+     *
+     * Empty strings and strings longer than the Excel limit of 32767
+     * characters can't be interned and return an invalid handle.
+     *
+     * Strings that are interned but not written to a cell are left out of
+     * the xlsx file, except in `constant_memory` mode where every interned
+     * string is written. Leaving them out means that the strings are
+     * numbered again, by a pass over the string cells, when the workbook is
+     * saved.
+     */
+    sst_handle intern_string(const std::string& string);
+
     /**
      * @brief Create a new chart to be added to a worksheet:
      *
@@ -363,6 +490,77 @@ public:
      */
     lxw_error close();
 
+    /**
+     * @brief Write the workbook to an XLSX file and keep it open for changes.
+     *
+     * @param path The name of the Excel file to write.
+     *
+     * @return A #lxw_error.
+     *
+     * The `%save()` function writes the workbook in the same way as `close()`
+     * but the workbook can still be changed and saved again afterwards, for
+     * example to regenerate a report periodically:
+     *
+     * @code
+     *     while (running) {
+     *         update_data(worksheet);
+     *         workbook->save("dashboard.xlsx");
+     *     }
+     * @endcode
+     *
+     * The compressed form of each worksheet and of the shared string table is
+     * kept after a save. Worksheets that haven't been written to or changed
+     * since the previous save, and an unchanged string table, are copied
+     * into the new file without being generated and compressed again. The
+     * other files in the package are reused when their content is identical.
+     *
+     * `%save()` isn't supported in `constant_memory` mode since the worksheet
+     * data has been discarded after it is written. It shouldn't be called
+     * after `close()`.
+     */
+    lxw_error save(const std::string& path);
+
+    /**
+     * @brief Close the Workbook object and write the XLSX file in the
+     *        background.
+     *
+     * @param options Optional executor and progress callback.
+     *
+     * @return A future holding the #lxw_error result of the close.
+     *
+     * The `%close_async()` function does the same work as `close()` but
+     * runs it on another thread so that the caller isn't blocked while the
+     * xlsx file is assembled:
+     *
+     * @code
+     *     std::future<lxw_error> result = workbook->close_async();
+     *
+     *     // Do other work.
+     *
+     *     return result.get();
+     * @endcode
+     *
+     * The background task holds a reference to the workbook so the caller
+     * can drop its own `workbook_ptr`. For this reason the workbook must have
+     * been created with `std::make_shared`. The workbook, and the worksheets,
+     * formats and charts it owns, must not be modified once `close_async()`
+     * has been called.
+     *
+     * The close can be stopped with `cancel_close()`, see below.
+     */
+    std::future<lxw_error> close_async(const close_options& options = close_options());
+
+    /**
+     * @brief Cancel a close started with `close_async()`.
+     *
+     * Requests that a pending `close_async()` stops at the next file in the
+     * xlsx package. The partially written xlsx file is removed and the
+     * future returns #LXW_ERROR_CLOSE_CANCELLED. It only applies to the
+     * latest `close_async()` and has no effect if that close has already
+     * finished. The workbook can be saved or closed again afterwards.
+     */
+    void cancel_close();
+
     /**
      * @brief Set the document properties such as Title, Author etc.
      *
@@ -568,6 +766,7 @@ private:
     std::map<std::string, worksheet_ptr> worksheet_names;
     std::vector<chart_ptr> charts;
     std::vector<chart*> ordered_charts;
+    std::vector<image_options_ptr> ordered_images;
     std::vector<format_ptr> formats;
     std::set<defined_name_ptr, sort_defined_names> defined_names;
 
@@ -577,8 +776,16 @@ private:
     std::string filename;
     workbook_options options;
 
-    uint16_t first_sheet;
-    uint16_t active_sheet;
+    /* Cancellation flag of the latest close_async(), shared with its task
+     * so that cancel_close() only affects that close. */
+    std::shared_ptr<std::atomic<bool>> close_cancelled;
+
+    /* Lock for the formats, charts and XF indices, which are shared by the
+     * worksheets. See @ref ww_mem_threads. */
+    std::mutex mutex;
+
+    std::atomic<uint16_t> first_sheet;
+    std::atomic<uint16_t> active_sheet;
     uint16_t num_xf_formats;
     uint16_t num_format_count;
     uint16_t drawing_count;
@@ -593,6 +800,26 @@ private:
     bool has_bmp;
 
     hash_table<format_ptr, format_ptr> used_xf_formats;
+    hash_table<format_spec, format_ptr> interned_formats;
+    size_t prepared_xf_formats;
+
+    /* The unique style elements in index order, kept across saves so that
+     * formats used after a save() are indexed consistently. The value is the
+     * first format to use the element, which styles.xml writes it from. */
+    hash_table<lxw_font, format_ptr> unique_fonts;
+    hash_table<lxw_border, format_ptr> unique_borders;
+    hash_table<lxw_fill, format_ptr> unique_fills;
+    hash_table<std::string, uint16_t> unique_num_formats;
+
+    /* The chart ranges resolved in the current save, by formula. */
+    hash_table<std::string, series_range_ptr> resolved_ranges;
+
+    /* Defined names added from the worksheet settings in the last save. */
+    std::vector<defined_name_ptr> sheet_defined_names;
+
+    /* Compressed parts kept between calls to save(). */
+    bool retain_parts;
+    part_cache saved_parts;
     //std::unordered_set<format_ptr> used_xf_formats;
     //std::vector<format_ptr> ordered_used_xf_formats;
 
@@ -620,10 +847,13 @@ private:
 //#endif /* TESTING */
 
     void _prepare_workbook();
-    void _prepare_num_formats();
-    void _prepare_fills();
-    void _prepare_borders();
-    void _prepare_fonts();
+    format* _add_format();
+    void _prepare_shared_strings();
+    void _prepare_styles();
+    void _prepare_font(format_ptr format);
+    void _prepare_num_format(format_ptr format);
+    void _prepare_border(format_ptr format);
+    void _prepare_fill(format_ptr format);
     void _populate_range_data_cache(const series_range_ptr &range);
     void _populate_range_dimensions(const series_range_ptr &range);
     void _populate_range(const series_range_ptr &range);
@@ -632,6 +862,9 @@ private:
     void _prepare_defined_names();
     void _write_sheet(const std::string &name, uint32_t sheet_id, uint8_t hidden);
     void workbook_new_opt(const workbook_options &options);
+    lxw_error _save(const std::string& path,
+                    const std::atomic<bool> *cancelled = nullptr,
+                    const std::function<void(uint32_t, uint32_t)>& progress = nullptr);
 };
 
 typedef std::shared_ptr<workbook> workbook_ptr;
@@ -17,6 +17,7 @@
 #include <list>
 #include <iterator>
 #include <memory>
+#include <atomic>
 
 #include "xmlwriter.hpp"
 #include "shared_strings.hpp"
@@ -26,6 +27,7 @@
 #include "common.hpp"
 #include "format.hpp"
 #include "utility.hpp"
+#include "part_cache.hpp"
 #include <map>
 
 #define LXW_ROW_MAX 1048576
@@ -45,6 +47,13 @@
 /** Default row height in Excel */
 #define LXW_DEF_ROW_HEIGHT (double)15.0
 
+/* The number of registers in a column string sketch is 1 << LXW_SKETCH_BITS. */
+#define LXW_SKETCH_BITS 8
+
+/* Number of strings written to an adaptive column between decisions on how
+ * to store its strings. */
+#define LXW_SKETCH_INTERVAL 512
+
 namespace xlsxwriter {
 
 /** Gridline options using in `worksheet_gridlines()`. */
@@ -59,6 +68,18 @@ enum lxw_gridlines {
     LXW_SHOW_ALL_GRIDLINES
 };
 
+/** How the strings written to a worksheet or column are stored. */
+enum lxw_string_storage {
+    /** Use the worksheet setting for a column. */
+    LXW_STRING_STORAGE_DEFAULT = 0,
+    /** Store the strings in the workbook shared string table. */
+    LXW_STRING_STORAGE_SHARED,
+    /** Store the strings inline in the worksheet cells. */
+    LXW_STRING_STORAGE_INLINE,
+    /** Choose for each column from the number of different strings in it. */
+    LXW_STRING_STORAGE_ADAPTIVE
+};
+
 enum cell_types {
     NUMBER_CELL = 1,
     STRING_CELL,
@@ -106,20 +127,43 @@ public:
  * Options struct for the worksheet_set_column() and worksheet_set_row()
  * functions.
  *
- * It has the following members but currently only the `hidden` property is
- * supported:
+ * It has the following members but currently only the `hidden` and
+ * `string_storage` properties are supported:
  *
  * * `hidden`
  * * `level`
  * * `collapsed`
+ * * `string_storage`
  */
 struct XLSXWRITER_EXPORT row_col_options {
-    row_col_options() : hidden(false), level(0), collapsed(false) {}
-    row_col_options(bool h, uint8_t l, bool c) : hidden(h), level(l), collapsed(c){}
+    row_col_options() : hidden(false), level(0), collapsed(false),
+                        string_storage(LXW_STRING_STORAGE_DEFAULT) {}
+    row_col_options(bool h, uint8_t l, bool c) : hidden(h), level(l), collapsed(c),
+                        string_storage(LXW_STRING_STORAGE_DEFAULT) {}
     /** Hide the row/column */
     bool hidden;
     uint8_t level;
     bool collapsed;
+
+    /** How the strings in the columns are stored, one of
+     *  #lxw_string_storage. Only used by `set_column_opt()`. */
+    uint8_t string_storage;
+};
+
+/*
+ * Estimate of the number of different strings written to a column, used to
+ * choose how to store them. It is a HyperLogLog sketch with 256 one byte
+ * registers, which has a standard error of about 6.5%.
+ */
+struct lxw_string_sketch {
+    lxw_string_sketch();
+
+    void add(uint64_t hash);
+    double estimate() const;
+
+    uint8_t registers[1 << LXW_SKETCH_BITS];
+    uint32_t count;
+    bool use_inline;
 };
 
 struct XLSXWRITER_EXPORT lxw_col_options {
@@ -147,11 +191,16 @@ struct XLSXWRITER_EXPORT lxw_merged_range {
         , last_row(0)
         , first_col(0)
         , last_col(0)
+        , format(nullptr)
     {}
     lxw_row_t first_row;
     lxw_row_t last_row;
     lxw_col_t first_col;
     lxw_col_t last_col;
+
+    /* Format of the blank cells of the range, which are written with the
+     * worksheet data instead of being stored as cells. */
+    xlsxwriter::format* format;
 };
 
 struct XLSXWRITER_EXPORT lxw_repeat_rows {
@@ -247,7 +296,8 @@ struct XLSXWRITER_EXPORT image_options {
         , row(0)
         , col(0)
         , anchor(0)
-        , stream(nullptr)
+        , data_hash(0)
+        , data_size(0)
         , image_type(0)
         , width(0.0)
         , height(0.0)
@@ -276,8 +326,14 @@ struct XLSXWRITER_EXPORT image_options {
     std::string tip;
     uint8_t anchor;
 
+    /** Description of the image, used as its alternative text. Defaults to
+     *  the image filename. */
+    std::string description;
+
     /* Internal metadata. */
-    FILE *stream;
+    std::vector<unsigned char> image_buffer;
+    uint64_t data_hash;
+    size_t data_size;
     uint8_t image_type;
     double width;
     double height;
@@ -286,6 +342,15 @@ struct XLSXWRITER_EXPORT image_options {
     double x_dpi;
     double y_dpi;
     xlsxwriter::chart* chart;
+
+    /* Whether the data of earlier images with the same hash and size is the
+     * same as the data of this image, so that each pair is compared once. */
+    std::map<const image_options *, bool> same_data;
+
+    /* Read the image data at offset from the buffer, or the next data from
+     * the open image file. */
+    size_t read_data(FILE *stream, size_t offset,
+                     unsigned char *buffer, size_t size) const;
 };
 
 typedef std::shared_ptr<image_options> image_options_ptr;
@@ -374,16 +439,18 @@ struct lxw_worksheet_init_data {
         , optimize(0)
         , active_sheet(nullptr)
         , first_sheet(nullptr)
+        , spool_threshold(LXW_SPOOL_THRESHOLD)
     {}
     uint32_t index;
     uint8_t hidden;
     uint8_t optimize;
-    uint16_t *active_sheet;
-    uint16_t *first_sheet;
+    std::atomic<uint16_t> *active_sheet;
+    std::atomic<uint16_t> *first_sheet;
     sst_ptr sst;
     std::string name;
     std::string quoted_name;
     std::string tmpdir;
+    size_t spool_threshold;
 
 };
 
@@ -424,11 +491,92 @@ struct XLSXWRITER_EXPORT lxw_cell {
     double formula_result;
     std::string *user_data1;
     std::string *user_data2;
-    std::string *sst_string;
 };
 
 class packager;
 class workbook;
+class worksheet;
+
+/**
+ * @brief A band of rows in a worksheet that can be written from its own thread.
+ *
+ * Worksheet bands are created with `worksheet::partition()`. Each band covers
+ * a range of rows of the worksheet and holds its own rows, cells and strings,
+ * so that different bands of the same worksheet can be written from
+ * different threads at the same time:
+ *
+ * @code
+ *     std::vector<xlsxwriter::worksheet_band *> bands = worksheet->partition(4, 250000);
+ *     std::vector<std::thread> threads;
+ *
+ *     for (auto band : bands) {
+ *         threads.push_back(std::thread([band]() {
+ *             for (lxw_row_t row = band->first_row(); row < band->end_row(); row++)
+ *                 band->write_number(row, 0, row);
+ *         }));
+ *     }
+ * @endcode
+ *
+ * The cells in the bands are moved into the worksheet, in row order, when the
+ * workbook is saved or closed. The strings are added to the shared string
+ * table at the same time so the output is the same as if the cells had been
+ * written to the worksheet in row order.
+ */
+class XLSXWRITER_EXPORT worksheet_band {
+    friend class worksheet;
+public:
+    ~worksheet_band();
+
+    /** The first row of the band. */
+    lxw_row_t first_row() const { return first_row_; }
+
+    /** The row after the last row of the band. */
+    lxw_row_t end_row() const { return end_row_; }
+
+    /** Write a number to a cell in the band. See `worksheet::write_number()`. */
+    lxw_error write_number(lxw_row_t row, lxw_col_t col, double number, format* pformat = nullptr);
+
+    /** Write a string to a cell in the band. See `worksheet::write_string()`. */
+    lxw_error write_string(lxw_row_t row, lxw_col_t col, const std::string& string, format* pformat = nullptr);
+
+    /** Write a formula to a cell in the band. See `worksheet::write_formula_num()`. */
+    lxw_error write_formula_num(lxw_row_t row, lxw_col_t col, const std::string& formula,
+                                format* pformat, double result);
+
+    /** Write a formula to a cell in the band. See `worksheet::write_formula()`. */
+    lxw_error write_formula(lxw_row_t row, lxw_col_t col, const std::string& formula, format* pformat = nullptr);
+
+    /** Write a blank cell to the band. See `worksheet::write_blank()`. */
+    lxw_error write_blank(lxw_row_t row, lxw_col_t col, format* pformat = nullptr);
+
+    /** Write a boolean to a cell in the band. See `worksheet::write_boolean()`. */
+    lxw_error write_boolean(lxw_row_t row, lxw_col_t col, bool value, format* pformat = nullptr);
+
+    /** Write a date or time to a cell in the band. See `worksheet::write_datetime()`. */
+    lxw_error write_datetime(lxw_row_t row, lxw_col_t col, lxw_datetime *datetime, format* pformat = nullptr);
+
+private:
+    worksheet_band(lxw_row_t first_row, lxw_row_t end_row);
+    worksheet_band(const worksheet_band&);
+    worksheet_band& operator=(const worksheet_band&);
+
+    lxw_error _check_dimensions(lxw_row_t row_num, lxw_col_t col_num);
+    void _insert_cell(lxw_row_t row_num, lxw_col_t col_num, lxw_cell *cell);
+
+    lxw_row_t first_row_;
+    lxw_row_t end_row_;
+
+    table_map table;
+
+    /* The strings of the string cells, which hold an index into this list
+     * until they are moved into the worksheet. */
+    std::vector<std::string> strings;
+
+    lxw_row_t dim_rowmin;
+    lxw_row_t dim_rowmax;
+    lxw_col_t dim_colmin;
+    lxw_col_t dim_colmax;
+};
 
 /**
  * @class worksheet The Worksheet object
@@ -558,6 +706,33 @@ public:
     lxw_error write_string(lxw_row_t row,
                            lxw_col_t col, const std::string& string,
                            format* pformat = nullptr);
+
+    /**
+     * @brief Write an interned string to a worksheet cell.
+     *
+     * @param row       The zero indexed row number.
+     * @param col       The zero indexed column number.
+     * @param string    A handle returned by workbook::intern_string().
+     * @param pformat   A pointer to a Format instance or NULL.
+     *
+     * @return A #lxw_error code.
+     *
+     * This version of `%write_string()` writes a string that was interned
+     * in the shared string table in advance. It avoids hashing and comparing
+     * the string for every cell, which helps when a small set of strings is
+     * written many times:
+     *
+     * @code
+     *     xlsxwriter::sst_handle region = workbook->intern_string("North");
+     *
+     *     for (row = 0; row < 1000000; row++)
+     *         worksheet->write_string(row, 0, region, NULL);
+     * @endcode
+     *
+     * An invalid handle returns #LXW_ERROR_SHARED_STRING_INDEX_NOT_FOUND.
+     */
+    lxw_error write_string(lxw_row_t row, lxw_col_t col, sst_handle string,
+                           format* pformat = nullptr);
     /**
      * @brief Write a formula to a worksheet cell.
      *
@@ -1181,6 +1356,9 @@ public:
      * BMP images are only supported for backward compatibility. In general it is
      * best to avoid BMP images since they aren't compressed. If used, BMP images
      * must be 24 bit, true color, bitmaps.
+     *
+     * An image that is inserted several times, in the same or different
+     * worksheets, is only stored once in the xlsx file.
      */
     lxw_error insert_image(lxw_row_t row, lxw_col_t col,
                            const std::string& filename);
@@ -1218,6 +1396,41 @@ public:
     lxw_error insert_image_opt(lxw_row_t row, lxw_col_t col,
                                const std::string& filename,
                                image_options* options = nullptr);
+
+    /**
+     * @brief Insert an image in a worksheet cell from a memory buffer.
+     *
+     * @param row          The zero indexed row number.
+     * @param col          The zero indexed column number.
+     * @param image_buffer Pointer to the image data in memory.
+     * @param image_size   Size of the image data in bytes.
+     * @param options      Optional image parameters.
+     *
+     * @return A #lxw_error code.
+     *
+     * This function is like `insert_image_opt()` except that the image data
+     * is taken from memory instead of a file. The data is copied so the
+     * buffer can be freed once the function returns:
+     *
+     * @code
+     *    image_options options;
+     *    options.description = "logo.png";
+     *
+     *    worksheet->insert_image_buffer(2, 1, data, size, &options);
+     * @endcode
+     *
+     * Images inserted from files are only read when they are inserted and
+     * when the workbook is saved, so the files must still exist at that
+     * point. Images that are created in memory, or many temporary files,
+     * should be inserted with this function instead.
+     *
+     * @note See the notes about row scaling and BMP images in
+     * `insert_image()` above.
+     */
+    lxw_error insert_image_buffer(lxw_row_t row, lxw_col_t col,
+                                  const uint8_t *image_buffer,
+                                  size_t image_size,
+                                  image_options* options = nullptr);
     /**
      * @brief Insert a chart object into a worksheet.
      *
@@ -1290,6 +1503,31 @@ public:
                                xlsxwriter::chart* chart,
                                image_options* user_options);
 
+    /**
+     * @brief Split the worksheet rows into bands that can be written from
+     *        separate threads.
+     *
+     * @param num_bands     The number of bands.
+     * @param rows_per_band The number of rows in each band. If it is 0 the
+     *                      rows of the worksheet are divided evenly.
+     *
+     * @return The bands, in row order. Band `k` covers the rows
+     *         `[k * rows_per_band, (k + 1) * rows_per_band)`. The list is
+     *         empty in `constant_memory` mode or if the bands would start
+     *         beyond the last row.
+     *
+     * See xlsxwriter::worksheet_band for an example. The bands are owned by
+     * the worksheet. They stay valid, and can be written again after a
+     * `workbook::save()`, until the next call to `%partition()`, which
+     * moves any cells in the old bands into the worksheet first.
+     *
+     * Each band can be written from its own thread, at the same time as the
+     * other bands. The worksheet itself mustn't be written while any of its
+     * bands are being written. The formats used in the bands follow the
+     * rules in @ref ww_mem_threads.
+     */
+    std::vector<worksheet_band *> partition(uint32_t num_bands, lxw_row_t rows_per_band = 0);
+
     /**
      * @brief Merge a range of cells.
      *
@@ -2332,6 +2570,42 @@ public:
      */
     void set_tab_color(lxw_color_t color);
 
+    /**
+     * @brief Set how the strings written to the worksheet are stored.
+     *
+     * @param storage One of #lxw_string_storage.
+     *
+     * Strings are normally stored once in the workbook shared string table
+     * and the cells refer to them by number. This is compact for strings that
+     * are repeated, but strings that are all different, such as ids or free
+     * text, only make the table grow. Those can be stored inline in the
+     * cells instead:
+     *
+     * - `LXW_STRING_STORAGE_SHARED`: Use the shared string table. This is
+     *   the default.
+     * - `LXW_STRING_STORAGE_INLINE`: Store the strings in the cells.
+     * - `LXW_STRING_STORAGE_ADAPTIVE`: Estimate the number of different
+     *   strings in each column and store the strings of columns where most
+     *   of them are different inline. The first strings in a column are
+     *   always shared, and the choice is reviewed every
+     *   #LXW_SKETCH_INTERVAL strings.
+     *
+     * The setting can be overridden for a column with the `string_storage`
+     * member of the `set_column_opt()` options:
+     *
+     * @code
+     *     worksheet->set_string_storage(xlsxwriter::LXW_STRING_STORAGE_ADAPTIVE);
+     *
+     *     xlsxwriter::row_col_options options;
+     *     options.string_storage = xlsxwriter::LXW_STRING_STORAGE_SHARED;
+     *     worksheet->set_column_opt(0, 0, LXW_DEF_COL_WIDTH, NULL, options);
+     * @endcode
+     *
+     * Strings are always inline in `constant_memory` mode, and strings
+     * written with an xlsxwriter::sst_handle are always shared.
+     */
+    void set_string_storage(uint8_t storage);
+
     /**
      * @brief Protect elements of a worksheet from modification.
      *
@@ -2455,14 +2729,16 @@ public:
     lxw_cell *find_cell(lxw_row *row, lxw_col_t col_num);
 
 private:
-    FILE *optimize_tmpfile;
+    std::unique_ptr<spool> optimize_tmpfile;
     table_map table;
     table_map hyperlinks;
     lxw_cell **array;
     std::vector<std::shared_ptr<lxw_merged_range>> merged_ranges;
+    std::vector<std::shared_ptr<lxw_merged_range>> merged_blank_ranges;
     std::vector<std::shared_ptr<lxw_selection>> selections;
     std::vector<std::shared_ptr<image_options>> image_data;
     std::vector<std::shared_ptr<image_options>> chart_data;
+    std::vector<std::unique_ptr<worksheet_band>> bands;
 
     lxw_row_t dim_rowmin;
     lxw_row_t dim_rowmax;
@@ -2477,9 +2753,13 @@ private:
     uint32_t index;
     uint8_t active;
     bool selected;
+
+    /* The worksheet was selected by save() or close() because no other
+     * worksheet was active. */
+    bool default_selected;
     uint8_t hidden;
-    uint16_t *active_sheet;
-    uint16_t *first_sheet;
+    std::atomic<uint16_t> *active_sheet;
+    std::atomic<uint16_t> *first_sheet;
 
     std::vector<std::unique_ptr<lxw_col_options>> col_options;
 
@@ -2488,8 +2768,23 @@ private:
 
     std::vector<xlsxwriter::format_ptr> col_formats;
 
+    /* How strings are stored, for the worksheet and for the columns that
+     * override it, and the sketches of the adaptive columns. */
+    uint8_t string_storage;
+    std::vector<uint8_t> col_string_storage;
+    std::vector<std::unique_ptr<lxw_string_sketch>> string_sketches;
+
     bool col_size_changed;
     bool row_size_changed;
+
+    /* Prefix sums of the column widths and of the differences from the
+     * default height of the rows that have one, in pixels, used to
+     * position objects. They are rebuilt for each save. */
+    std::vector<uint32_t> col_size_sums;
+    std::vector<lxw_row_t> row_size_rows;
+    std::vector<int64_t> row_size_sums;
+    bool size_index_valid;
+
     uint8_t optimize;
     std::unique_ptr<lxw_row> optimize_row;
 
@@ -2556,6 +2851,7 @@ private:
     std::list<rel_tuple_ptr> external_hyperlinks;
     std::list<rel_tuple_ptr> external_drawing_links;
     std::list<rel_tuple_ptr> drawing_links;
+    std::map<std::string, uint16_t> drawing_rel_ids;
 
     lxw_panes panes;
 
@@ -2563,6 +2859,11 @@ private:
 
     std::shared_ptr<xlsxwriter::drawing> drawing;
 
+    /* Set by the write and settings functions. A worksheet that isn't dirty
+     * is added to the next workbook::save() from saved_part. */
+    bool dirty;
+    part_cache_member_ptr saved_part;
+
     /* Declarations required for unit testing. */
     void _xml_declaration();
     void _write_worksheet();
@@ -2591,14 +2892,16 @@ private:
     uint32_t _calculate_x_split_width(double x_split) const;
     void _write_cell(lxw_cell *cell, xlsxwriter::format* row_format);
     void _write_rows();
+    void _write_merged_rows();
+    bool _in_merged_blank_range(lxw_row_t row_num, lxw_col_t col_num);
     void _write_drawing(uint16_t id);
     void _write_drawings();
-    void _position_object_emus(const image_options_ptr &image, const drawing_object_ptr &drawing_object);
+    void _position_object_emus(const image_options_ptr &image, double width, double height, const drawing_object_ptr &drawing_object);
     void _write_formula_num_cell(lxw_cell *cell);
     void _write_array_formula_num_cell(lxw_cell *cell);
     void _write_inline_string_cell(const std::string &range, int32_t style_index, lxw_cell *cell);
     void _write_freeze_panes();
-    void _position_object_pixels(const image_options_ptr &image, const drawing_object_ptr &drawing_object);
+    void _position_object_pixels(const image_options_ptr &image, double width, double height, const drawing_object_ptr &drawing_object);
     void _write_string_cell(const std::string &range, int32_t style_index, lxw_cell *cell);
     void _write_number_cell(const std::string &range, int32_t style_index, lxw_cell *cell);
     void _write_split_panes();
@@ -2610,6 +2913,9 @@ private:
     void _write_page_set_up_pr();
     void _write_cols();
     int32_t _size_row(lxw_row_t row_num);
+    void _index_sizes();
+    uint32_t _col_offset(lxw_col_t col_num);
+    uint32_t _row_offset(lxw_row_t row_num);
     void _write_panes();
     void _write_selections();
     lxw_row *_get_row(lxw_row_t row_num);
@@ -2621,6 +2927,9 @@ private:
     void _write_boolean_cell(lxw_cell *cell);
     void _insert_cell(lxw_row_t row_num, lxw_col_t col_num, lxw_cell *cell);
     void _insert_hyperlink(lxw_row_t row_num, lxw_col_t col_num, lxw_cell *link);
+    void _merge_bands();
+    bool _use_inline_string(lxw_col_t col_num, const std::string& string);
+    std::string *_copy_inline_string(const std::string& string);
     void _calculate_spans(table_map::iterator it , char *span, int32_t *block_num);
 };
 
@@ -23,6 +23,7 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include "common.hpp"
+#include "spool.hpp"
 #include <list>
 
 #include <string>
@@ -128,7 +129,7 @@ protected:
 
     std::string lxw_escape_data(const std::string& data);
 
-    FILE* file;
+    spool* file;
 
 private:
     void _fprint_escaped_attributes(const std::list<std::pair<std::string, std::string> > &attributes);
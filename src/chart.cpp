@@ -11,7 +11,17 @@
 #include <xlsxwriter/chart.hpp>
 #include <xlsxwriter/utility.hpp>
 #include <math.h>
+#include <list>
 #include <memory>
+#include <mutex>
+#include <unordered_map>
+
+/* Maximum number of chart fragments kept in the cache. */
+#define LXW_CHART_FRAGMENT_CACHE_SIZE 256
+
+/* Elements written into the slots of a chart fragment. */
+#define LXW_CHART_SLOT_AXIS_ID    0
+#define LXW_CHART_SLOT_CROSS_AXIS 1
 
 namespace xlsxwriter {
 
@@ -33,6 +43,10 @@ chart::chart(uint8_t type)
     cross_between = 0;
 
     series_index = 0;
+    initialized = false;
+
+    recording = NULL;
+    recording_offset = 0;
 
     cat_has_num_fmt = false;
 
@@ -96,6 +110,17 @@ chart::chart(uint8_t type)
     has_horiz_val_axis = true;
 }
 
+/*
+ * Process wide cache of the recorded chart fragments, by key, with the most
+ * recently used fragments first. The fragments are immutable once they are
+ * added.
+ */
+typedef std::list<std::pair<std::string, chart_fragment_ptr> > fragment_list;
+
+static std::mutex fragment_mutex;
+static fragment_list fragment_lru;
+static std::unordered_map<std::string, fragment_list::iterator> fragment_cache;
+
 /*
  * Free a chart object.
  */
@@ -149,6 +174,47 @@ void chart::set_range(const series_range_ptr& range, const std::string& sheetnam
     range->formula = formula;
 }
 
+/*
+ * Set the cached data of a range from an array of numbers. The range isn't
+ * read back from the worksheet.
+ */
+void chart::set_range_data(const series_range_ptr& range, const double *data,
+                           uint32_t num_points)
+{
+    uint32_t i;
+
+    range->ignore_cache = true;
+    range->user_data = true;
+    range->has_string_cache = false;
+    range->data_cache = std::make_shared<series_data_cache>();
+    range->data_cache->reserve(num_points);
+
+    for (i = 0; i < num_points; i++) {
+        if (isnan(data[i]))
+            range->data_cache->add_missing();
+        else
+            range->data_cache->add_number(data[i]);
+    }
+}
+
+/*
+ * Set the cached data of a range from an array of strings.
+ */
+void chart::set_range_data(const series_range_ptr& range,
+                           const std::string *data, uint32_t num_points)
+{
+    uint32_t i;
+
+    range->ignore_cache = true;
+    range->user_data = true;
+    range->has_string_cache = true;
+    range->data_cache = std::make_shared<series_data_cache>();
+    range->data_cache->reserve(num_points);
+
+    for (i = 0; i < num_points; i++)
+        range->data_cache->add_string(data[i]);
+}
+
 /*****************************************************************************
  *
  * XML functions.
@@ -457,7 +523,7 @@ void chart::_write_a_body_pr(chart_title *title)
 /*
  * Write the <c:ptCount> element.
  */
-void chart::_write_pt_count(uint16_t num_data_points)
+void chart::_write_pt_count(uint32_t num_data_points)
 {
     xml_attribute_list attributes = {
         {"val", std::to_string(num_data_points)}
@@ -497,10 +563,10 @@ void chart::_write_f(const std::string& formula)
 /*
  * Write the <c:pt> element.
  */
-void chart::_write_pt(uint16_t index, const std::shared_ptr<series_data_point>& data_point)
+void chart::_write_pt(const series_data_cache& cache, uint32_t index)
 {
     /* Ignore chart points that have no data. */
-    if (data_point->no_data)
+    if (cache.is_missing(index))
         return;
 
     xml_attribute_list attributes = {
@@ -509,10 +575,15 @@ void chart::_write_pt(uint16_t index, const std::shared_ptr<series_data_point>&
 
     lxw_xml_start_tag("c:pt", attributes);
 
-    if (data_point->is_string && !data_point->string->empty())
-        _write_v_str(*data_point->string);
-    else
-        _write_v_num(data_point->number);
+    if (cache.has_string(index)) {
+        size_t offset = cache.string_offsets[index];
+
+        _write_v_str(cache.string_data.substr(
+                         offset, cache.string_offsets[index + 1] - offset));
+    }
+    else {
+        _write_v_num(cache.numbers[index]);
+    }
 
     lxw_xml_end_tag("c:pt");
 }
@@ -520,10 +591,10 @@ void chart::_write_pt(uint16_t index, const std::shared_ptr<series_data_point>&
 /*
  * Write the <c:pt> element.
  */
-void chart::_write_num_pt(uint16_t index, const std::shared_ptr<series_data_point>& data_point)
+void chart::_write_num_pt(const series_data_cache& cache, uint32_t index)
 {
     /* Ignore chart points that have no data. */
-    if (data_point->no_data)
+    if (cache.is_missing(index))
         return;
 
     xml_attribute_list attributes = {
@@ -532,7 +603,7 @@ void chart::_write_num_pt(uint16_t index, const std::shared_ptr<series_data_poin
 
     lxw_xml_start_tag("c:pt", attributes);
 
-    _write_v_num(data_point->number);
+    _write_v_num(cache.numbers[index]);
 
     lxw_xml_end_tag("c:pt");
 }
@@ -550,7 +621,8 @@ void chart::_write_num_pt(uint16_t index, const std::shared_ptr<series_data_poin
  */
 void chart::_write_num_cache(const series_range_ptr& range)
 {
-    uint16_t index = 0;
+    const series_data_cache& cache = *range->data_cache;
+    uint32_t index;
 
     lxw_xml_start_tag("c:numCache");
 
@@ -558,12 +630,11 @@ void chart::_write_num_cache(const series_range_ptr& range)
     _write_format_code();
 
     /* Write the c:ptCount element. */
-    _write_pt_count(range->num_data_points);
+    _write_pt_count(cache.size());
 
-    for(const auto& data_point: range->data_cache) {
+    for (index = 0; index < cache.size(); index++) {
         /* Write the c:pt element. */
-        _write_num_pt(index, data_point);
-        index++;
+        _write_num_pt(cache, index);
     }
 
     lxw_xml_end_tag("c:numCache");
@@ -574,17 +645,17 @@ void chart::_write_num_cache(const series_range_ptr& range)
  */
 void chart::_write_str_cache(const series_range_ptr& range)
 {
-    uint16_t index = 0;
+    const series_data_cache& cache = *range->data_cache;
+    uint32_t index;
 
     lxw_xml_start_tag("c:strCache");
 
     /* Write the c:ptCount element. */
-    _write_pt_count(range->num_data_points);
+    _write_pt_count(cache.size());
 
-    for (const auto& data_point : range->data_cache) {
+    for (index = 0; index < cache.size(); index++) {
         /* Write the c:pt element. */
-        _write_pt(index, data_point);
-        index++;
+        _write_pt(cache, index);
     }
 
     lxw_xml_end_tag("c:strCache");
@@ -600,7 +671,7 @@ void chart::_write_num_ref(const series_range_ptr& range)
     /* Write the c:f element. */
     _write_f(range->formula);
 
-    if (!range->data_cache.empty()) {
+    if (!range->data_cache->empty()) {
         /* Write the c:numCache element. */
         _write_num_cache(range);
     }
@@ -618,7 +689,7 @@ void chart::_write_str_ref(const series_range_ptr& range)
     /* Write the c:f element. */
     _write_f(range->formula);
 
-    if (range->data_cache.size() > 0) {
+    if (!range->data_cache->empty()) {
         /* Write the c:strCache element. */
         _write_str_cache(range);
     }
@@ -910,6 +981,9 @@ void chart::_write_order(uint16_t index)
  */
 void chart::_write_axis_id(uint32_t axis_id)
 {
+    if (recording && _record_slot(LXW_CHART_SLOT_AXIS_ID, axis_id))
+        return;
+
     xml_attribute_list attributes = {
         {"val", std::to_string(axis_id)}
     };
@@ -1288,6 +1362,9 @@ void chart::_write_tick_lbl_pos()
  */
 void chart::_write_cross_axis(uint32_t axis_id)
 {
+    if (recording && _record_slot(LXW_CHART_SLOT_CROSS_AXIS, axis_id))
+        return;
+
     xml_attribute_list attributes = {
         {"val", std::to_string(axis_id)}
     };
@@ -1766,23 +1843,18 @@ void chart::_write_chart()
     /* Write the c:plotArea element. */
     write_plot_area();
 
-    /* Write the c:legend element. */
-    _write_legend();
-
-    /* Write the c:plotVisOnly element. */
-    _write_plot_vis_only();
-
-    lxw_xml_end_tag("c:chart");
+    /* Write the rest of the c:chart element and the file. */
+    _write_fragment("tail:" + std::to_string(legend_position)
+                    + (type == LXW_CHART_PIE || type == LXW_CHART_DOUGHNUT
+                       ? ":pie" : ""),
+                    &chart::_write_chart_tail);
 }
 
 /*
- * Assemble and write the XML file.
+ * Write the start of the file, up to the c:chart element.
  */
-void chart::assemble_xml_file()
+void chart::_write_chart_head()
 {
-    /* Initialize the chart specific properties. */
-    _initialize();
-
     /* Write the XML declaration. */
     _xml_declaration();
 
@@ -1794,9 +1866,20 @@ void chart::assemble_xml_file()
 
     /* Write the c:style element. */
     _write_style();
+}
 
-    /* Write the c:chart element. */
-    _write_chart();
+/*
+ * Write the end of the file, from the c:legend element.
+ */
+void chart::_write_chart_tail()
+{
+    /* Write the c:legend element. */
+    _write_legend();
+
+    /* Write the c:plotVisOnly element. */
+    _write_plot_vis_only();
+
+    lxw_xml_end_tag("c:chart");
 
     /* Write the c:printSettings element. */
     _write_print_settings();
@@ -1804,6 +1887,209 @@ void chart::assemble_xml_file()
     lxw_xml_end_tag("c:chartSpace");
 }
 
+/*
+ * Format an axis value for a fragment key. Unset values, which are NaN, all
+ * have the same key.
+ */
+static std::string _fragment_key_value(double value)
+{
+    if (isnan(value))
+        return std::string();
+
+    return to_string(value);
+}
+
+static std::string _fragment_key_value(const std::string& value)
+{
+    return std::to_string(value.size()) + "=" + value;
+}
+
+/*
+ * Get the key of the axes fragment of the chart. Returns false if the axes
+ * have settings, such as titles, that are too varied to cache.
+ */
+bool chart::_axes_fragment_key(std::string& key)
+{
+    const std::shared_ptr<chart_axis> axes[] = {x_axis, y_axis, x2_axis, y2_axis};
+    uint8_t flags[] = {
+        (uint8_t) cat_has_num_fmt, has_horiz_cat_axis, has_horiz_val_axis,
+        (uint8_t) (axis_id_1 || axis_id_2), (uint8_t) (axis_id_3 || axis_id_4)
+    };
+
+    if (combined)
+        return false;
+
+    /* The values are added as text, with the numbers formatted as they are
+     * written, and the strings prefixed with their length. */
+    key = "axes";
+
+    for (uint8_t flag : flags)
+        key += ":" + std::to_string(flag);
+
+    key += ":" + std::to_string(cross_between);
+
+    for (const auto& axis : axes) {
+        if (!axis->title.name.empty() || !axis->title.range->formula.empty()
+            || axis->major_gridlines_sp_pr)
+            return false;
+
+        key += "|" + _fragment_key_value(axis->min_value);
+        key += ":" + _fragment_key_value(axis->max_value);
+        key += ":" + std::to_string(axis->title.angle);
+        key += ":" + std::to_string(axis->title.is_horizontal);
+        key += ":" + std::to_string(axis->default_major_gridlines);
+        key += ":" + std::to_string(axis->major_tick_mark);
+        key += ":" + std::to_string(axis->position);
+        key += ":" + std::to_string(axis->visible);
+        key += ":" + _fragment_key_value(axis->num_format);
+        key += ":" + _fragment_key_value(axis->default_num_format);
+        key += ":" + _fragment_key_value(axis->crossing);
+    }
+
+    return true;
+}
+
+/*
+ * Write part of the chart from the fragment cache. On a miss the writer is
+ * called to record the fragment. The axis ids are written into its slots.
+ */
+void chart::_write_fragment(const std::string& key, void (chart::*writer)())
+{
+    uint32_t axis_ids[] = {axis_id_1, axis_id_2, axis_id_3, axis_id_4};
+    chart_fragment_ptr fragment;
+    size_t i;
+
+    {
+        std::lock_guard<std::mutex> lock(fragment_mutex);
+        auto it = fragment_cache.find(key);
+
+        if (it != fragment_cache.end()) {
+            fragment_lru.splice(fragment_lru.begin(), fragment_lru, it->second);
+            fragment = it->second->second;
+        }
+    }
+
+    if (!fragment) {
+        std::shared_ptr<chart_fragment> recorded = std::make_shared<chart_fragment>();
+        spool buffer(std::string(), SIZE_MAX);
+        spool *output = file;
+
+        recorded->cacheable = true;
+        recording = recorded.get();
+        recording_offset = 0;
+        file = &buffer;
+
+        (this->*writer)();
+
+        recorded->literals.push_back(
+            std::string(buffer.data() + recording_offset,
+                        buffer.size() - recording_offset));
+
+        file = output;
+        recording = NULL;
+        fragment = recorded;
+
+        if (recorded->cacheable) {
+            std::lock_guard<std::mutex> lock(fragment_mutex);
+            auto it = fragment_cache.find(key);
+
+            /* Another thread may have recorded the same fragment. */
+            if (it != fragment_cache.end()) {
+                fragment_lru.erase(it->second);
+                fragment_cache.erase(it);
+            }
+
+            fragment_lru.push_front(std::make_pair(key, fragment));
+            fragment_cache[key] = fragment_lru.begin();
+
+            /* Drop the least recently used fragments. */
+            while (fragment_lru.size() > LXW_CHART_FRAGMENT_CACHE_SIZE) {
+                fragment_cache.erase(fragment_lru.back().first);
+                fragment_lru.pop_back();
+            }
+        }
+    }
+
+    for (i = 0; i < fragment->literals.size(); i++) {
+        file->write(fragment->literals[i]);
+
+        if (i == fragment->slots.size())
+            break;
+
+        uint8_t slot = fragment->slots[i];
+
+        if (slot >> 2 == LXW_CHART_SLOT_AXIS_ID)
+            _write_axis_id(axis_ids[slot & 3]);
+        else
+            _write_cross_axis(axis_ids[slot & 3]);
+    }
+}
+
+/*
+ * Record an axis id element as a slot of the fragment being recorded.
+ * Returns false, and marks the fragment as not cacheable, if the id isn't
+ * one of the chart axis ids.
+ */
+bool chart::_record_slot(uint8_t type, uint32_t axis_id)
+{
+    uint32_t axis_ids[] = {axis_id_1, axis_id_2, axis_id_3, axis_id_4};
+    uint8_t slot = 4;
+    uint8_t i;
+
+    for (i = 0; i < 4; i++) {
+        if (axis_ids[i] != axis_id)
+            continue;
+
+        /* The slot would be ambiguous for charts with other ids. */
+        if (slot != 4) {
+            recording->cacheable = false;
+            return false;
+        }
+
+        slot = i;
+    }
+
+    if (slot == 4) {
+        recording->cacheable = false;
+        return false;
+    }
+
+    recording->literals.push_back(
+        std::string(file->data() + recording_offset,
+                    file->size() - recording_offset));
+    recording->slots.push_back((uint8_t) ((type << 2) | slot));
+    recording_offset = file->size();
+
+    return true;
+}
+
+/*
+ * Assemble and write the XML file.
+ */
+void chart::assemble_xml_file()
+{
+    /* Initialize the chart specific properties. This is only done once since
+     * a chart may be assembled again by workbook::save() and bar charts swap
+     * their axes. */
+    if (!initialized) {
+        _initialize();
+        initialized = true;
+    }
+
+    /* Reset the state left behind by a previous assembly. */
+    series_index = 0;
+    x_axis->title.is_horizontal = false;
+    y_axis->title.is_horizontal = false;
+
+    /* The parts of the file that are the same for many charts are written
+     * from the fragment cache. */
+    _write_fragment("head:" + std::to_string(style_id),
+                    &chart::_write_chart_head);
+
+    /* Write the c:chart element and the rest of the file. */
+    _write_chart();
+}
+
 /*****************************************************************************
  *
  * Public functions.
@@ -1814,19 +2100,18 @@ void chart::assemble_xml_file()
  * Add data to a data cache in a range object, for testing only.
  */
 int chart_add_data_cache(series_range *range, uint8_t *data,
-                         uint16_t rows, uint8_t cols, uint8_t col)
+                         uint32_t rows, uint8_t cols, uint8_t col)
 {
-    uint16_t i;
+    uint32_t i;
 
     range->ignore_cache = true;
-    range->num_data_points = rows;
+    range->user_data = true;
 
     /* Initialize the series range data cache. */
-    for (i = 0; i < rows; i++) {
-        std::shared_ptr<series_data_point> data_point = std::make_shared<series_data_point>();
-        range->data_cache.push_back(data_point);
-        data_point->number = data[i * cols + col];
-    }
+    range->data_cache->reserve(rows);
+
+    for (i = 0; i < rows; i++)
+        range->data_cache->add_number(data[i * cols + col]);
 
     return 0;
 }
@@ -1944,6 +2229,28 @@ void chart_series::set_values(const std::string& sheetname,
     chart::set_range(values, sheetname, first_row, first_col, last_row, last_col);
 }
 
+/*
+ * Set the cached data of the values range for a series.
+ */
+void chart_series::set_values_data(const double *data, uint32_t num_points)
+{
+    chart::set_range_data(values, data, num_points);
+}
+
+/*
+ * Set the cached data of the categories range for a series.
+ */
+void chart_series::set_categories_data(const double *data, uint32_t num_points)
+{
+    chart::set_range_data(categories, data, num_points);
+}
+
+void chart_series::set_categories_data(const std::string *data,
+                                       uint32_t num_points)
+{
+    chart::set_range_data(categories, data, num_points);
+}
+
 /*
  * Set an axis caption.
  */
@@ -2143,7 +2450,10 @@ void chart::write_plot_area()
     const std::shared_ptr<chart>& second_chart = combined;
     if (second_chart)
     {
-        second_chart->_initialize();
+        if (!second_chart->initialized) {
+            second_chart->_initialize();
+            second_chart->initialized = true;
+        }
 
         second_chart->id = second_chart->is_secondary ? id + 1000 : id;
         second_chart->file = file;
@@ -2152,6 +2462,36 @@ void chart::write_plot_area()
         second_chart->write_chart_type(false);
     }
 
+    std::string key;
+
+    /* The axes of charts with the same settings only differ by their ids. */
+    if (_axes_fragment_key(key)) {
+        _write_fragment(key, &chart::_write_axes);
+
+        /* Apply the title settings that writing the axes would have made. */
+        if (axis_id_1 || axis_id_2) {
+            x_axis->title.is_horizontal = has_horiz_cat_axis;
+            y_axis->title.is_horizontal = has_horiz_val_axis;
+        }
+        if (axis_id_3 || axis_id_4) {
+            x2_axis->title.is_horizontal = has_horiz_cat_axis;
+            y2_axis->title.is_horizontal = has_horiz_val_axis;
+        }
+    }
+    else {
+        _write_axes();
+    }
+
+    lxw_xml_end_tag("c:plotArea");
+}
+
+/*
+ * Write the axis elements of the plot area.
+ */
+void chart::_write_axes()
+{
+    const std::shared_ptr<chart>& second_chart = combined;
+
     val_axis_args args;
     args.x_axis = x_axis;
     args.y_axis = y_axis;
@@ -2185,8 +2525,6 @@ void chart::write_plot_area()
 
     /* TODO add c:dTable elemnt */
     /* TODO add c:spPr element */
-
-    lxw_xml_end_tag("c:plotArea");
 }
 
 void chart_area::_initialize()
@@ -2603,7 +2941,53 @@ series_range::series_range()
 {
     has_string_cache = false;
     ignore_cache = false;
-    num_data_points = 0;
+    user_data = false;
+    data_cache = std::make_shared<series_data_cache>();
+}
+
+void series_data_cache::clear()
+{
+    numbers.clear();
+    missing.clear();
+    string_data.clear();
+    string_offsets.clear();
+}
+
+void series_data_cache::reserve(uint32_t num_points)
+{
+    numbers.reserve(num_points);
+    missing.reserve(num_points);
+}
+
+void series_data_cache::add_number(double number)
+{
+    numbers.push_back(number);
+    missing.push_back(false);
+
+    if (!string_offsets.empty())
+        string_offsets.push_back(string_data.size());
+}
+
+/*
+ * Add a string point. The string offsets of the earlier points are filled in
+ * when the first string is added.
+ */
+void series_data_cache::add_string(const std::string& string)
+{
+    if (string_offsets.empty())
+        string_offsets.assign(numbers.size() + 1, 0);
+
+    numbers.push_back(0);
+    missing.push_back(false);
+
+    string_data.append(string);
+    string_offsets.push_back(string_data.size());
+}
+
+void series_data_cache::add_missing()
+{
+    add_number(0);
+    missing.back() = true;
 }
 
 } //namespace xlsxwriter
@@ -337,8 +337,9 @@ void drawing::_write_pic(uint16_t index, const drawing_object_ptr& drawing_objec
     /* Write the xdr:nvPicPr element. */
     _write_nv_pic_pr(index, drawing_object);
 
-    /* Write the xdr:blipFill element. */
-    _write_blip_fill(index);
+    /* Write the xdr:blipFill element. Pictures of the same image share a
+     * relationship. */
+    _write_blip_fill(drawing_object->rel_index);
 
     /* Write the xdr:spPr element. */
     _write_sp_pr(drawing_object);
@@ -24,6 +24,9 @@ namespace xlsxwriter {
  */
 format::format()
 {
+    /* Clear any padding as well, since format keys are compared bytewise. */
+    memset((void *) this, 0, sizeof(format));
+
     xf_format_indices = NULL;
 
     xf_index = LXW_PROPERTY_UNSET;
@@ -136,6 +139,7 @@ format* format::_get_format_key()
     /* Set pointer members to NULL since they aren't part of the comparison. */
     key->xf_format_indices = NULL;
     key->num_xf_formats = NULL;
+    key->xf_format_mutex = NULL;
 
     return key;
 }
@@ -143,24 +147,24 @@ format* format::_get_format_key()
 /*
  * Returns a font struct suitable for hashing as a lookup key.
  */
-lxw_font * format::get_font_key()
-{
-    lxw_font *key = new lxw_font{};
-
-    lxw_strcpy(key->font_name, font_name);
-    key->font_size = font_size;
-    key->bold = bold;
-    key->italic = italic;
-    key->font_color = font_color;
-    key->underline = underline;
-    key->font_strikeout = font_strikeout;
-    key->font_outline = font_outline;
-    key->font_shadow = font_shadow;
-    key->font_script = font_script;
-    key->font_family = font_family;
-    key->font_charset = font_charset;
-    key->font_condense = font_condense;
-    key->font_extend = font_extend;
+lxw_font format::get_font_key() const
+{
+    lxw_font key;
+
+    lxw_strcpy(key.font_name, font_name);
+    key.font_size = font_size;
+    key.bold = bold;
+    key.italic = italic;
+    key.font_color = font_color;
+    key.underline = underline;
+    key.font_strikeout = font_strikeout;
+    key.font_outline = font_outline;
+    key.font_shadow = font_shadow;
+    key.font_script = font_script;
+    key.font_family = font_family;
+    key.font_charset = font_charset;
+    key.font_condense = font_condense;
+    key.font_extend = font_extend;
 
     return key;
 }
@@ -168,21 +172,21 @@ lxw_font * format::get_font_key()
 /*
  * Returns a border struct suitable for hashing as a lookup key.
  */
-lxw_border * format::get_border_key()
+lxw_border format::get_border_key() const
 {
-    lxw_border *key = new lxw_border{};
+    lxw_border key;
 
-    key->bottom = bottom;
-    key->left = left;
-    key->right = right;
-    key->top = top;
-    key->diag_border = diag_border;
-    key->diag_type = diag_type;
-    key->bottom_color = bottom_color;
-    key->left_color = left_color;
-    key->right_color = right_color;
-    key->top_color = top_color;
-    key->diag_color = diag_color;
+    key.bottom = bottom;
+    key.left = left;
+    key.right = right;
+    key.top = top;
+    key.diag_border = diag_border;
+    key.diag_type = diag_type;
+    key.bottom_color = bottom_color;
+    key.left_color = left_color;
+    key.right_color = right_color;
+    key.top_color = top_color;
+    key.diag_color = diag_color;
 
     return key;
 }
@@ -190,13 +194,13 @@ lxw_border * format::get_border_key()
 /*
  * Returns a pattern fill struct suitable for hashing as a lookup key.
  */
-lxw_fill * format::get_fill_key()
+lxw_fill format::get_fill_key() const
 {
-    lxw_fill *key = new lxw_fill{};
+    lxw_fill key;
 
-    key->fg_color = fg_color;
-    key->bg_color = bg_color;
-    key->pattern = pattern;
+    key.fg_color = fg_color;
+    key.bg_color = bg_color;
+    key.pattern = pattern;
 
     return key;
 }
@@ -213,6 +217,11 @@ int32_t format::get_xf_index()
      * more importantly the *used* formats in the workbook.
      */
 
+    /* The table is shared by all the worksheets of the workbook. */
+    std::unique_lock<std::mutex> lock;
+    if (xf_format_mutex)
+        lock = std::unique_lock<std::mutex>(*xf_format_mutex);
+
     /* Format already has an index number so return it. */
     if (xf_index != LXW_PROPERTY_UNSET) {
         return xf_index;
@@ -228,28 +237,96 @@ int32_t format::get_xf_index()
         return 0;
 
     /* Look up the format in the hash table. */
-    auto result = formats_hash_table->exists(format_key);
+    auto result = formats_hash_table->insert(format_key, this);
 
-    if (result.second) {
+    if (!result.second) {
         delete format_key;
         /* Format matches existing format with an index. */
-        format_ptr existing_format = result.first.first;
-        return existing_format->xf_index;
+        xf_index = result.first->second->xf_index;
+        return xf_index;
     }
     else {
         /* New format requiring an index. */
-        index = formats_hash_table->order_list.size();
+        index = formats_hash_table->size() - 1;
         xf_index = index;
-        formats_hash_table->insert(format_key, this);
         return index;
     }
 }
 
+/*
+ * Create a format spec with the default properties.
+ */
+format_spec::format_spec()
+{
+    format defaults;
+
+    _init(defaults);
+}
+
+/*
+ * Create a format spec from the properties of a format.
+ */
+format_spec::format_spec(const format& format)
+{
+    _init(format);
+}
+
+/*
+ * Copy the format properties, clearing the members that refer to a workbook
+ * or that are set when the workbook is prepared, and hash the result.
+ */
+void format_spec::_init(const format& format)
+{
+    memcpy((void *) &properties, (const void *) &format, sizeof(xlsxwriter::format));
+
+    properties.file = NULL;
+    properties.xf_format_indices = NULL;
+    properties.num_xf_formats = NULL;
+    properties.xf_format_mutex = NULL;
+    properties.xf_index = LXW_PROPERTY_UNSET;
+    properties.dxf_index = LXW_PROPERTY_UNSET;
+    properties.font_index = 0;
+    properties.has_font = false;
+    properties.fill_index = 0;
+    properties.has_fill = false;
+    properties.border_index = 0;
+    properties.has_border = false;
+
+    hash_value = lxw_hash_bytes(&properties, sizeof(xlsxwriter::format));
+}
+
+format_spec::format_spec(const format_spec& other)
+{
+    *this = other;
+}
+
+/*
+ * Copy the properties bytewise, since the padding is part of the comparison.
+ */
+format_spec& format_spec::operator=(const format_spec& other)
+{
+    memcpy((void *) &properties, (const void *) &other.properties,
+           sizeof(format));
+    hash_value = other.hash_value;
+
+    return *this;
+}
+
+bool format_spec::operator==(const format_spec& other) const
+{
+    return hash_value == other.hash_value
+           && memcmp((const void *) &properties, (const void *) &other.properties,
+                     sizeof(format)) == 0;
+}
+
 /*
  * Set the font_name property.
  */
 void format::set_font_name(const std::string& name)
 {
+    /* Clear the end of a longer previous value, since format specs are
+     * compared bytewise. */
+    memset(font_name, 0, LXW_FORMAT_FIELD_LEN);
     lxw_strcpy(font_name, name.c_str());
 }
 
@@ -336,6 +413,9 @@ void format::set_font_shadow()
  */
 void format::set_num_format(const std::string& format)
 {
+    /* Clear the end of a longer previous value, since format specs are
+     * compared bytewise. */
+    memset(num_format, 0, LXW_FORMAT_FIELD_LEN);
     lxw_strcpy(num_format, format.c_str());
 }
 
@@ -605,6 +685,9 @@ void format::set_font_charset(uint8_t value)
  */
 void format::set_font_scheme(const std::string& value)
 {
+    /* Clear the end of a longer previous value, since format specs are
+     * compared bytewise. */
+    memset(font_scheme, 0, LXW_FORMAT_FIELD_LEN);
     lxw_strcpy(font_scheme, value.c_str());
 }
 
@@ -0,0 +1,117 @@
+/*****************************************************************************
+ * gen_theme - Generator for the pre-deflated theme1.xml part.
+ *
+ * Used in conjunction with the libxlsxwriter library.
+ *
+ * Copyright 2014-2016, John McNamara, jmcnamara@cpan.org. See LICENSE.txt.
+ *
+ * The theme XML is the same in every workbook so it is deflated once here,
+ * using the same zlib settings as the packager, and written out as a C++
+ * source file along with its CRC32 and uncompressed size. The packager then
+ * copies it into the zip as a raw member. The output is checked in as
+ * src/theme_deflated.cpp and regenerated with the lxw_regenerate_theme
+ * target whenever theme_strs.h changes.
+ *
+ * Usage: gen_theme <output.cpp>
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <zlib.h>
+
+#include <string>
+#include <vector>
+
+#include "theme_strs.h"
+
+#ifndef DEF_MEM_LEVEL
+#define DEF_MEM_LEVEL 8
+#endif
+
+using namespace xlsxwriter;
+
+int main(int argc, char *argv[])
+{
+    std::string xml;
+    std::vector<unsigned char> deflated;
+    z_stream stream;
+    uint32_t crc;
+    FILE *file;
+    size_t i;
+    int err;
+
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s <output.cpp>\n", argv[0]);
+        return 1;
+    }
+
+    for (i = 0; strlen(theme_strs[i]); i++)
+        xml += theme_strs[i];
+
+    memset(&stream, 0, sizeof(stream));
+
+    /* Raw deflate, matching the settings in packager::_open_zip_member(). */
+    err = deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                       -MAX_WBITS, DEF_MEM_LEVEL, Z_DEFAULT_STRATEGY);
+    if (err != Z_OK) {
+        fprintf(stderr, "%s: deflateInit2() failed: %d\n", argv[0], err);
+        return 1;
+    }
+
+    deflated.resize(deflateBound(&stream, (uLong) xml.size()));
+
+    stream.next_in = (Bytef *) xml.data();
+    stream.avail_in = (uInt) xml.size();
+    stream.next_out = &deflated[0];
+    stream.avail_out = (uInt) deflated.size();
+
+    err = deflate(&stream, Z_FINISH);
+    if (err != Z_STREAM_END) {
+        fprintf(stderr, "%s: deflate() failed: %d\n", argv[0], err);
+        deflateEnd(&stream);
+        return 1;
+    }
+
+    deflated.resize(stream.total_out);
+    deflateEnd(&stream);
+
+    crc = (uint32_t) crc32(0L, (const Bytef *) xml.data(), (uInt) xml.size());
+
+    file = fopen(argv[1], "w");
+    if (!file) {
+        fprintf(stderr, "%s: couldn't create '%s'\n", argv[0], argv[1]);
+        return 1;
+    }
+
+    fprintf(file,
+            "/* Generated by gen_theme from theme_strs.h. Do not edit. */\n"
+            "\n"
+            "#include <xlsxwriter/theme.hpp>\n"
+            "\n"
+            "namespace xlsxwriter {\n"
+            "\n"
+            "const unsigned char theme_deflated[] = {");
+
+    for (i = 0; i < deflated.size(); i++)
+        fprintf(file, "%s0x%02x,", i % 12 ? " " : "\n    ", deflated[i]);
+
+    fprintf(file,
+            "\n};\n"
+            "\n"
+            "const size_t theme_deflated_size = %lu;\n"
+            "const size_t theme_uncompressed_size = %lu;\n"
+            "const uint32_t theme_crc32 = 0x%08lxUL;\n"
+            "\n"
+            "} // namespace xlsxwriter\n",
+            (unsigned long) deflated.size(),
+            (unsigned long) xml.size(),
+            (unsigned long) crc);
+
+    if (fclose(file) != 0) {
+        fprintf(stderr, "%s: couldn't write '%s'\n", argv[0], argv[1]);
+        return 1;
+    }
+
+    return 0;
+}
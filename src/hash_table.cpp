@@ -13,22 +13,23 @@
 #include <stdint.h>
 #include "xlsxwriter/hash_table.hpp"
 
+namespace xlsxwriter {
+
 /*
- * Calculate the hash key using the FNV function. See:
+ * Calculate the hash key using the FNV-1a function. See:
  * http://en.wikipedia.org/wiki/Fowler-Noll-Vo_hash_function
  */
-size_t _generate_hash_key(void *data, size_t data_len, size_t num_buckets)
+uint64_t lxw_hash_bytes(const void *data, size_t data_len, uint64_t hash)
 {
-    unsigned char *p = (unsigned char*)data;
-    size_t hash = 2166136261U;
+    const unsigned char *p = (const unsigned char *) data;
     size_t i;
 
-    for (i = 0; i < data_len; i++)
-        hash = (hash * 16777619) ^ p[i];
+    for (i = 0; i < data_len; i++) {
+        hash ^= p[i];
+        hash *= 1099511628211ULL;
+    }
 
-    return hash % num_buckets;
-}
-size_t generate_hash_key(const std::string &data)
-{
-    return _generate_hash_key((void*)data.c_str(), data.size(), INT16_MAX);
+    return hash;
 }
+
+} // namespace xlsxwriter
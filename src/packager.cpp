@@ -12,6 +12,10 @@
 #include <xlsxwriter/hash_table.hpp>
 #include <xlsxwriter/utility.hpp>
 
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 namespace xlsxwriter {
 
 uint8_t _add_file_to_zip(FILE * file, const char *filename);
@@ -68,9 +72,16 @@ _open_zipfile_win32(const char *filename)
 /*
  * Create a new packager object.
  */
-packager::packager(const std::string& filename, const std::string& tmpdir)
-    : chart_count(0)
+packager::packager(const std::string& filename, const std::string& tmpdir,
+                   size_t spool_threshold)
+    : spool_threshold(spool_threshold)
+    , cache(NULL)
+    , threads(1)
+    , chart_count(0)
     , drawing_count(0)
+    , cancelled(NULL)
+    , parts_written(0)
+    , parts_total(0)
 {
     this->filename = filename;
     this->tmpdir = tmpdir;
@@ -107,17 +118,14 @@ packager::packager(const std::string& filename, const std::string& tmpdir)
  */
 uint8_t packager::_write_workbook_file()
 {
-    workbook->file = lxw_tmpfile(tmpdir.c_str());
-    if (!workbook->file)
-        return LXW_ERROR_CREATING_TMPFILE;
+    spool part(tmpdir, spool_threshold);
+    workbook->file = &part;
 
     workbook->assemble_xml_file();
 
-    uint8_t err = _add_file_to_zip( workbook->file, "xl/workbook.xml");
+    uint8_t err = _add_file_to_zip(part, "xl/workbook.xml");
     RETURN_ON_ERROR(err);
 
-    fclose(workbook->file);
-
     return 0;
 }
 
@@ -137,16 +145,29 @@ uint8_t packager::_write_worksheet_files()
         if (worksheet->optimize_row)
             worksheet->write_single_row();
 
-        worksheet->file = lxw_tmpfile(tmpdir.c_str());
-        if (!worksheet->file)
-            return LXW_ERROR_CREATING_TMPFILE;
+        /* Reuse the worksheet from the last save() if it hasn't changed. */
+        if (workbook->retain_parts && !worksheet->dirty
+            && worksheet->saved_part) {
+            err = _add_member_to_zip(sheetname, worksheet->saved_part);
+            RETURN_ON_ERROR(err);
+            continue;
+        }
+
+        spool part(tmpdir, spool_threshold);
+        worksheet->file = &part;
 
         worksheet->assemble_xml_file();
 
-        err = _add_file_to_zip(worksheet->file, sheetname);
-        RETURN_ON_ERROR(err);
-
-        fclose(worksheet->file);
+        if (workbook->retain_parts) {
+            err = _add_retained_file_to_zip(part, sheetname,
+                                            worksheet->saved_part);
+            RETURN_ON_ERROR(err);
+            worksheet->dirty = false;
+        }
+        else {
+            err = _add_file_to_zip(part, sheetname);
+            RETURN_ON_ERROR(err);
+        }
     }
 
     return 0;
@@ -162,22 +183,32 @@ uint8_t packager::_write_image_files()
     char filename[LXW_FILENAME_LENGTH] = { 0 };
     uint16_t index = 1;
 
-    for(const auto& sheet : workbook->worksheets) {
-
-        if (sheet->image_data.empty())
-            continue;
-
-        for (const auto& image : sheet->image_data) {
-            lxw_snprintf(filename, LXW_FILENAME_LENGTH,
-                         "xl/media/image%d.%s", index++, image->extension.c_str());
-
-            rewind(image->stream);
+    /* Each distinct image is stored once, however often it is inserted. */
+    for (const auto& image : workbook->ordered_images) {
+        lxw_snprintf(filename, LXW_FILENAME_LENGTH,
+                     "xl/media/image%d.%s", index++, image->extension.c_str());
 
-            err = _add_file_to_zip(image->stream, filename);
+        if (!image->image_buffer.empty()) {
+            err = _add_buffer_to_zip(
+                      (const char *) image->image_buffer.data(),
+                      image->image_buffer.size(), filename);
             RETURN_ON_ERROR(err);
+            continue;
+        }
 
-            fclose(image->stream);
+        /* The image files are only kept open while they are copied, to
+         * bound the number of open files. */
+        FILE *image_stream = fopen(image->filename.c_str(), "rb");
+        if (!image_stream) {
+            LXW_WARN_FORMAT1("workbook_close(): "
+                             "couldn't reopen image file: %s.",
+                             image->filename.c_str());
+            return LXW_ERROR_IMAGE_FILE_OPEN;
         }
+
+        err = _add_file_to_zip(image_stream, filename);
+        fclose(image_stream);
+        RETURN_ON_ERROR(err);
     }
 
     return 0;
@@ -190,6 +221,8 @@ uint8_t packager::_write_chart_files()
 {
     char sheetname[LXW_FILENAME_LENGTH] = { 0 };
     uint16_t index = 1;
+    uint16_t max_threads = threads;
+    std::vector<package_part> parts;
     int err;
 
     for(const auto& chart: workbook->ordered_charts) {
@@ -197,19 +230,24 @@ uint8_t packager::_write_chart_files()
         lxw_snprintf(sheetname, LXW_FILENAME_LENGTH,
                      "xl/charts/chart%d.xml", index++);
 
-        chart->file = lxw_tmpfile(tmpdir.c_str());
-        if (!chart->file)
-            return LXW_ERROR_CREATING_TMPFILE;
-
-        chart->assemble_xml_file();
-
-        err = _add_file_to_zip(chart->file, sheetname);
-        RETURN_ON_ERROR(err);
+        package_part part;
+        part.filename = sheetname;
+        part.assemble = [chart](spool& file) {
+            chart->file = &file;
+            chart->assemble_xml_file();
+        };
+        parts.push_back(part);
+
+        /* A combined chart is written by the chart it is combined with, so
+         * it mustn't also be written on another thread. */
+        if (chart->combined && chart->combined->in_use)
+            max_threads = 1;
+    }
 
-        chart_count++;
+    err = _add_parts_to_zip(parts, max_threads);
+    RETURN_ON_ERROR(err);
 
-        fclose(chart->file);
-    }
+    chart_count += (uint16_t) parts.size();
 
     return 0;
 }
@@ -221,29 +259,31 @@ uint8_t packager::_write_drawing_files()
 {
     char filename[LXW_FILENAME_LENGTH] = { 0 };
     uint16_t index = 1;
+    std::vector<package_part> parts;
     int err;
 
     for(const auto& worksheet : workbook->worksheets) {
-        const std::shared_ptr<xlsxwriter::drawing>& drawing = worksheet->drawing;
+        std::shared_ptr<xlsxwriter::drawing> drawing = worksheet->drawing;
 
         if (drawing) {
             lxw_snprintf(filename, LXW_FILENAME_LENGTH,
                          "xl/drawings/drawing%d.xml", index++);
 
-            drawing->file = lxw_tmpfile(tmpdir.c_str());
-            if (!drawing->file)
-                return LXW_ERROR_CREATING_TMPFILE;
-
-            drawing->assemble_xml_file();
-            err = _add_file_to_zip(drawing->file, filename);
-            RETURN_ON_ERROR(err);
-
-            fclose(drawing->file);
-
-            drawing_count++;
+            package_part part;
+            part.filename = filename;
+            part.assemble = [drawing](spool& file) {
+                drawing->file = &file;
+                drawing->assemble_xml_file();
+            };
+            parts.push_back(part);
         }
     }
 
+    err = _add_parts_to_zip(parts, threads);
+    RETURN_ON_ERROR(err);
+
+    drawing_count += (uint16_t) parts.size();
+
     return 0;
 }
 
@@ -259,16 +299,31 @@ uint8_t packager::_write_shared_strings_file()
     if (sst->string_count == 0)
         return 0;
 
-    sst->file = lxw_tmpfile(tmpdir.c_str());
-    if (!sst->file)
-        return LXW_ERROR_CREATING_TMPFILE;
+    /* Every string written increments string_count so the table from the
+     * last save() can be reused if it hasn't changed. */
+    if (workbook->retain_parts && sst->saved_part
+        && sst->saved_string_count == sst->string_count) {
+        return _add_member_to_zip("xl/sharedStrings.xml", sst->saved_part);
+    }
+
+    spool part(tmpdir, spool_threshold);
+    sst->file = &part;
 
     sst->assemble_xml_file();
 
-    err = _add_file_to_zip(sst->file, "xl/sharedStrings.xml");
+    err = sst->error();
     RETURN_ON_ERROR(err);
 
-    fclose(sst->file);
+    if (workbook->retain_parts) {
+        err = _add_retained_file_to_zip(part, "xl/sharedStrings.xml",
+                                        sst->saved_part);
+        RETURN_ON_ERROR(err);
+        sst->saved_string_count = sst->string_count;
+    }
+    else {
+        err = _add_file_to_zip(part, "xl/sharedStrings.xml");
+        RETURN_ON_ERROR(err);
+    }
 
     return 0;
 }
@@ -283,9 +338,8 @@ uint8_t packager::_write_app_file()
     std::string number;
     int err;
 
-    app->file = lxw_tmpfile(tmpdir.c_str());
-    if (!app->file)
-        return LXW_ERROR_CREATING_TMPFILE;
+    spool part(tmpdir, spool_threshold);
+    app->file = &part;
 
     number = std::to_string( workbook->worksheets.size());
 
@@ -318,11 +372,9 @@ uint8_t packager::_write_app_file()
 
     app->assemble_xml_file();
 
-    err = _add_file_to_zip(app->file, "docProps/app.xml");
+    err = _add_file_to_zip(part, "docProps/app.xml");
     RETURN_ON_ERROR(err);
 
-    fclose(app->file);
-
     return 0;
 }
 
@@ -334,19 +386,16 @@ uint8_t packager::_write_core_file()
     std::shared_ptr<xlsxwriter::core> core = std::make_shared<xlsxwriter::core>();
     int err;
 
-    core->file = lxw_tmpfile(tmpdir.c_str());
-    if (!core->file)
-        return LXW_ERROR_CREATING_TMPFILE;
+    spool part(tmpdir, spool_threshold);
+    core->file = &part;
 
     core->properties = &workbook->properties;
 
     core->assemble_xml_file();
 
-    err = _add_file_to_zip(core->file, "docProps/core.xml");
+    err = _add_file_to_zip(part, "docProps/core.xml");
     RETURN_ON_ERROR(err);
 
-    fclose(core->file);
-
     return 0;
 }
 
@@ -363,38 +412,29 @@ uint8_t packager::_write_custom_file()
 
     custom_ptr custom = std::make_shared<xlsxwriter::custom>(workbook->custom_properties);
 
-    custom->file = lxw_tmpfile(tmpdir.c_str());
-    if (!custom->file)
-        return LXW_ERROR_CREATING_TMPFILE;
+    spool part(tmpdir, spool_threshold);
+    custom->file = &part;
 
     custom->assemble_xml_file();
 
-    err = _add_file_to_zip(custom->file, "docProps/custom.xml");
+    err = _add_file_to_zip(part, "docProps/custom.xml");
     RETURN_ON_ERROR(err);
 
-    fclose(custom->file);
-
     return 0;
 }
 
 /*
- * Write the theme.xml file.
+ * Write the theme.xml file. The theme is constant so it is deflated once by
+ * gen_theme.cpp and copied into the zip as a raw member.
  */
 uint8_t packager::_write_theme_file()
 {
-    std::shared_ptr<xlsxwriter::theme> theme = std::make_shared<xlsxwriter::theme>();
     int err;
 
-    theme->file = lxw_tmpfile(tmpdir.c_str());
-    if (!theme->file)
-        return LXW_ERROR_CREATING_TMPFILE;
-
-    theme->assemble_xml_file();
-
-    err = _add_file_to_zip(theme->file, "xl/theme/theme1.xml");
+    err = _add_raw_file_to_zip("xl/theme/theme1.xml",
+                               theme_deflated, theme_deflated_size,
+                               theme_crc32, theme_uncompressed_size);
     RETURN_ON_ERROR(err);
-
-    fclose(theme->file);
     return 0;
 }
 
@@ -408,33 +448,34 @@ uint8_t packager::_write_styles_file()
 
     /* Copy the unique and in-use formats from the workbook to the styles
      * xf_format list. */
-    for (const auto& pair : workbook->used_xf_formats.order_list) {
+    for (const auto& pair : workbook->used_xf_formats) {
         /*
         xlsxwriter::format *workbook_format = (xlsxwriter::format *) hash_element->value;
         xlsxwriter::format *style_format = xlsxwriter::format_new();
         memcpy(style_format, workbook_format, sizeof(xlsxwriter::format));
         STAILQ_INSERT_TAIL(styles->xf_formats, style_format, list_pointers);
         */
-        styles->xf_formats.push_back(pair.first);
+        styles->xf_formats.push_back(pair.second);
     }
 
     styles->font_count = workbook->font_count;
     styles->border_count = workbook->border_count;
     styles->fill_count = workbook->fill_count;
     styles->num_format_count = workbook->num_format_count;
-    styles->xf_count = workbook->used_xf_formats.order_list.size();
+    styles->fonts = &workbook->unique_fonts;
+    styles->borders = &workbook->unique_borders;
+    styles->fills = &workbook->unique_fills;
+    styles->num_formats = &workbook->unique_num_formats;
+    styles->xf_count = workbook->used_xf_formats.size();
 
-    styles->file = lxw_tmpfile(tmpdir.c_str());
-    if (!styles->file)
-        return LXW_ERROR_CREATING_TMPFILE;
+    spool part(tmpdir, spool_threshold);
+    styles->file = &part;
 
     styles->assemble_xml_file();
 
-    err = _add_file_to_zip(styles->file, "xl/styles.xml");
+    err = _add_file_to_zip(part, "xl/styles.xml");
     RETURN_ON_ERROR(err);
 
-    fclose(styles->file);
-
     return 0;
 }
 
@@ -448,9 +489,8 @@ uint8_t packager::_write_content_types_file()
     uint16_t index = 1;
     int err;
 
-    content_types->file = lxw_tmpfile(tmpdir.c_str());
-    if (!content_types->file)
-        return LXW_ERROR_CREATING_TMPFILE;
+    spool part(tmpdir, spool_threshold);
+    content_types->file = &part;
 
     if (workbook->has_png)
         content_types->add_default("png", "image/png");
@@ -488,11 +528,9 @@ uint8_t packager::_write_content_types_file()
 
     content_types->assemble_xml_file();
 
-    err = _add_file_to_zip(content_types->file, "[Content_Types].xml");
+    err = _add_file_to_zip(part, "[Content_Types].xml");
     RETURN_ON_ERROR(err);
 
-    fclose(content_types->file);
-
     return 0;
 }
 
@@ -506,9 +544,8 @@ uint8_t packager::_write_workbook_rels_file()
     uint16_t index = 1;
     int err;
 
-    rels->file = lxw_tmpfile(tmpdir.c_str());
-    if (!rels->file)
-        return LXW_ERROR_CREATING_TMPFILE;
+    spool part(tmpdir, spool_threshold);
+    rels->file = &part;
 
     for(const auto& worksheet : workbook->worksheets) {
         (void)worksheet;
@@ -525,11 +562,9 @@ uint8_t packager::_write_workbook_rels_file()
 
     rels->assemble_xml_file();
 
-    err = _add_file_to_zip(rels->file, "xl/_rels/workbook.xml.rels");
+    err = _add_file_to_zip(part, "xl/_rels/workbook.xml.rels");
     RETURN_ON_ERROR(err);
 
-    fclose(rels->file);
-
     return 0;
 }
 
@@ -552,9 +587,8 @@ uint8_t packager::_write_worksheet_rels_file()
             continue;
 
         relationships_ptr rels = std::make_shared<relationships>();
-        rels->file = lxw_tmpfile(tmpdir.c_str());
-        if (!rels->file)
-            return LXW_ERROR_CREATING_TMPFILE;
+        spool part(tmpdir, spool_threshold);
+        rels->file = &part;
 
         for (const auto& rel : worksheet->external_hyperlinks) {
             rels->add_worksheet(rel->type, rel->target, rel->target_mode);
@@ -569,10 +603,8 @@ uint8_t packager::_write_worksheet_rels_file()
 
         rels->assemble_xml_file();
 
-        err = _add_file_to_zip(rels->file, sheetname);
+        err = _add_file_to_zip(part, sheetname);
         RETURN_ON_ERROR(err);
-
-        fclose(rels->file);
     }
 
     return 0;
@@ -594,9 +626,8 @@ uint8_t packager::_write_drawing_rels_file()
             continue;
 
         std::shared_ptr<relationships> rels = std::make_shared<relationships>();
-        rels->file = lxw_tmpfile(tmpdir.c_str());
-        if (!rels->file)
-            return LXW_ERROR_CREATING_TMPFILE;
+        spool part(tmpdir, spool_threshold);
+        rels->file = &part;
 
         for (const auto& rel : worksheet->drawing_links) {
             rels->add_worksheet(rel->type, rel->target, rel->target_mode);
@@ -607,10 +638,8 @@ uint8_t packager::_write_drawing_rels_file()
 
         rels->assemble_xml_file();
 
-        err = _add_file_to_zip(rels->file, sheetname);
+        err = _add_file_to_zip(part, sheetname);
         RETURN_ON_ERROR(err);
-
-        fclose(rels->file);
     }
 
     return 0;
@@ -624,9 +653,8 @@ uint8_t packager::_write_root_rels_file()
     relationships_ptr rels = std::make_shared<relationships>();
     int err;
 
-    rels->file = lxw_tmpfile(tmpdir.c_str());
-    if (!rels->file)
-        return LXW_ERROR_CREATING_TMPFILE;
+    spool part(tmpdir, spool_threshold);
+    rels->file = &part;
 
     rels->add_document("/officeDocument", "xl/workbook.xml");
 
@@ -639,11 +667,9 @@ uint8_t packager::_write_root_rels_file()
 
     rels->assemble_xml_file();
 
-    err = _add_file_to_zip(rels->file, "_rels/.rels");
+    err = _add_file_to_zip(part, "_rels/.rels");
     RETURN_ON_ERROR(err);
 
-    fclose(rels->file);
-
     return 0;
 }
 
@@ -653,19 +679,23 @@ uint8_t packager::_write_root_rels_file()
  *
  ****************************************************************************/
 
-uint8_t packager::_add_file_to_zip(FILE * file, const char *filename)
+/*
+ * Start a new deflated member in the zip file. In raw mode the caller writes
+ * data that has already been deflated.
+ */
+uint8_t packager::_open_zip_member(const char *filename, bool raw)
 {
-    int16_t error = ZIP_OK;
-    size_t size_read;
-    size_t buffer_size = LXW_ZIP_BUFFER_SIZE;
-    char buffer[LXW_ZIP_BUFFER_SIZE];
-    memset((void*)buffer, 0, LXW_ZIP_BUFFER_SIZE);
+    int16_t error;
+
+    /* Stop at a member boundary if the close has been cancelled. */
+    if (cancelled && *cancelled)
+        return LXW_ERROR_CLOSE_CANCELLED;
 
     error = zipOpenNewFileInZip4_64(zipfile,
                                     filename,
                                     &zipfile_info,
                                     NULL, 0, NULL, 0, NULL,
-                                    Z_DEFLATED, Z_DEFAULT_COMPRESSION, 0,
+                                    Z_DEFLATED, Z_DEFAULT_COMPRESSION, raw,
                                     -MAX_WBITS, DEF_MEM_LEVEL,
                                     Z_DEFAULT_STRATEGY, NULL, 0, 0, 0, 0);
 
@@ -674,6 +704,82 @@ uint8_t packager::_add_file_to_zip(FILE * file, const char *filename)
         RETURN_ON_ZIP_ERROR(error, LXW_ERROR_ZIP_FILE_ADD);
     }
 
+    return 0;
+}
+
+/*
+ * Close the current member in the zip file. Raw members need the CRC32 and
+ * uncompressed size of the original data since minizip hasn't seen it.
+ */
+uint8_t packager::_close_zip_member(bool raw, uint32_t crc,
+                                    size_t uncompressed_size)
+{
+    int16_t error;
+
+    if (raw)
+        error = zipCloseFileInZipRaw64(zipfile, uncompressed_size, crc);
+    else
+        error = zipCloseFileInZip(zipfile);
+
+    if (error != ZIP_OK) {
+        LXW_ERROR("Error in closing member in the zipfile");
+        RETURN_ON_ZIP_ERROR(error, LXW_ERROR_ZIP_FILE_ADD);
+    }
+
+    parts_written++;
+
+    if (progress)
+        progress(parts_written, parts_total);
+
+    return 0;
+}
+
+/*
+ * Count the files that will be added to the package, for progress reporting.
+ */
+uint32_t packager::_count_parts()
+{
+    /* workbook.xml, app.xml, core.xml, theme1.xml, styles.xml,
+     * [Content_Types].xml, workbook.xml.rels and .rels. */
+    uint32_t count = 8;
+
+    count += workbook->ordered_charts.size();
+    count += workbook->ordered_images.size();
+
+    if (workbook->sst->string_count)
+        count++;
+
+    if (!workbook->custom_properties.empty())
+        count++;
+
+    for (const auto& worksheet : workbook->worksheets) {
+        count++;
+
+        if (worksheet->drawing)
+            count++;
+
+        if (!worksheet->external_hyperlinks.empty()
+            || !worksheet->external_drawing_links.empty())
+            count++;
+
+        if (!worksheet->drawing_links.empty())
+            count++;
+    }
+
+    return count;
+}
+
+uint8_t packager::_add_file_to_zip(FILE * file, const char *filename)
+{
+    int16_t error = ZIP_OK;
+    size_t size_read;
+    size_t buffer_size = LXW_ZIP_BUFFER_SIZE;
+    char buffer[LXW_ZIP_BUFFER_SIZE];
+    memset((void*)buffer, 0, LXW_ZIP_BUFFER_SIZE);
+
+    error = _open_zip_member(filename);
+    RETURN_ON_ERROR(error);
+
     fflush(file);
     rewind(file);
 
@@ -698,27 +804,280 @@ uint8_t packager::_add_file_to_zip(FILE * file, const char *filename)
         size_read = fread(buffer, 1, buffer_size, file);
     }
 
-    if (error < 0) {
-        RETURN_ON_ZIP_ERROR(error, LXW_ERROR_ZIP_FILE_ADD);
+    return _close_zip_member();
+}
+
+/*
+ * Add a spooled XML part to the zip file. Parts that are still in memory are
+ * deflated directly from the spool buffer without an intermediate copy.
+ */
+uint8_t packager::_add_file_to_zip(spool& part, const char *filename)
+{
+    int16_t error = ZIP_OK;
+    size_t size_read;
+    char buffer[LXW_ZIP_BUFFER_SIZE];
+
+    if (part.error())
+        return part.error();
+
+    if (cache && part.in_memory())
+        return _add_cached_file_to_zip(part, filename);
+
+    if (part.in_memory())
+        return _add_buffer_to_zip(part.data(), part.size(), filename);
+
+    error = _open_zip_member(filename);
+    RETURN_ON_ERROR(error);
+
+    part.rewind();
+
+    size_read = part.read(buffer, LXW_ZIP_BUFFER_SIZE);
+
+    while (size_read) {
+        error = zipWriteInFileInZip(zipfile, buffer, (unsigned int) size_read);
+
+        if (error < 0) {
+            LXW_ERROR("Error in writing member in the zipfile");
+            RETURN_ON_ZIP_ERROR(error, LXW_ERROR_ZIP_FILE_ADD);
+        }
+
+        size_read = part.read(buffer, LXW_ZIP_BUFFER_SIZE);
     }
-    else {
-        error = zipCloseFileInZip(zipfile);
-        if (error != ZIP_OK) {
-            LXW_ERROR("Error in closing member in the zipfile");
+
+    return _close_zip_member();
+}
+
+/*
+ * Add data in memory, such as an image inserted from a buffer, to the zip
+ * file.
+ */
+uint8_t packager::_add_buffer_to_zip(const char *data, size_t size,
+                                     const char *filename)
+{
+    int16_t error;
+    size_t size_written;
+
+    error = _open_zip_member(filename);
+    RETURN_ON_ERROR(error);
+
+    while (size) {
+        size_written = size < UINT32_MAX ? size : UINT32_MAX;
+
+        error = zipWriteInFileInZip(zipfile, data, (unsigned int) size_written);
+
+        if (error < 0) {
+            LXW_ERROR("Error in writing member in the zipfile");
             RETURN_ON_ZIP_ERROR(error, LXW_ERROR_ZIP_FILE_ADD);
         }
+
+        data += size_written;
+        size -= size_written;
     }
 
-    return 0;
+    return _close_zip_member();
 }
 
 /*
- * Write the xml files that make up the XLXS OPC package.
+ * Add a spooled part via the part cache, reusing the deflated data from an
+ * identical part in this or an earlier workbook.
+ */
+uint8_t packager::_add_cached_file_to_zip(spool& part, const char *filename)
+{
+    part_cache_member_ptr member = cache->get(part.data(), part.size());
+
+    if (!member) {
+        LXW_ERROR("Error compressing member for the zipfile");
+        return LXW_ERROR_ZIP_FILE_ADD;
+    }
+
+    return _add_member_to_zip(filename, member);
+}
+
+/*
+ * Compress a part and keep the result so that it can be reused by the next
+ * workbook::save().
+ */
+uint8_t packager::_add_retained_file_to_zip(spool& part, const char *filename,
+                                            part_cache_member_ptr& saved_part)
+{
+    if (part.error())
+        return part.error();
+
+    saved_part = part_cache::compress(part);
+
+    if (!saved_part) {
+        LXW_ERROR("Error compressing member for the zipfile");
+        return LXW_ERROR_ZIP_FILE_ADD;
+    }
+
+    return _add_member_to_zip(filename, saved_part);
+}
+
+/*
+ * Add a previously compressed part to the zip file.
+ */
+uint8_t packager::_add_member_to_zip(const char *filename,
+                                     const part_cache_member_ptr& member)
+{
+    return _add_raw_file_to_zip(filename, member->deflated.data(),
+                                member->deflated.size(), member->crc32,
+                                member->uncompressed_size);
+}
+
+/*
+ * Assemble and compress independent parts on up to max_threads worker
+ * threads and add them to the zip file in order, as each one is ready. A
+ * max_threads of 0 uses one thread per processor.
+ */
+uint8_t packager::_add_parts_to_zip(std::vector<package_part>& parts,
+                                    uint16_t max_threads)
+{
+    size_t num_threads = max_threads ? max_threads
+                                     : std::thread::hardware_concurrency();
+    std::vector<std::thread> workers;
+    std::vector<bool> ready(parts.size(), false);
+    std::atomic<size_t> next(0);
+    std::atomic<bool> stop(false);
+    std::condition_variable part_ready;
+    std::mutex mutex;
+    uint8_t err = 0;
+    size_t i;
+
+    if (num_threads > parts.size())
+        num_threads = parts.size();
+
+    /* Assemble the parts in turn on this thread. */
+    if (num_threads <= 1) {
+        for (auto& package_part : parts) {
+            spool part(tmpdir, spool_threshold);
+
+            package_part.assemble(part);
+
+            err = _add_file_to_zip(part, package_part.filename.c_str());
+            RETURN_ON_ERROR(err);
+        }
+
+        return 0;
+    }
+
+    auto worker = [&]() {
+        size_t index;
+
+        while (!stop && (index = next++) < parts.size()) {
+            package_part& package_part = parts[index];
+            spool part(tmpdir, spool_threshold);
+
+            package_part.assemble(part);
+            package_part.error = part.error();
+
+            if (!package_part.error) {
+                if (cache && part.in_memory())
+                    package_part.member = cache->get(part.data(), part.size());
+                else
+                    package_part.member = part_cache::compress(part);
+
+                if (!package_part.member) {
+                    LXW_ERROR("Error compressing member for the zipfile");
+                    package_part.error = LXW_ERROR_ZIP_FILE_ADD;
+                }
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                ready[index] = true;
+            }
+            part_ready.notify_all();
+        }
+    };
+
+    for (i = 0; i < num_threads; i++)
+        workers.push_back(std::thread(worker));
+
+    /* Add the parts in order, so the file numbering is unchanged. */
+    for (i = 0; i < parts.size(); i++) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            part_ready.wait(lock, [&]() { return ready[i]; });
+        }
+
+        err = parts[i].error;
+        if (!err)
+            err = _add_member_to_zip(parts[i].filename.c_str(),
+                                     parts[i].member);
+
+        parts[i].member.reset();
+
+        if (err)
+            break;
+    }
+
+    stop = true;
+
+    for (auto& thread : workers)
+        thread.join();
+
+    return err;
+}
+
+/*
+ * Add a member that has already been deflated, such as the pre-deflated
+ * theme, to the zip file without compressing it again.
+ */
+uint8_t packager::_add_raw_file_to_zip(const char *filename,
+                                       const unsigned char *data,
+                                       size_t size, uint32_t crc,
+                                       size_t uncompressed_size)
+{
+    int16_t error;
+    size_t size_written;
+
+    error = _open_zip_member(filename, true);
+    RETURN_ON_ERROR(error);
+
+    while (size) {
+        size_written = size < UINT32_MAX ? size : UINT32_MAX;
+
+        error = zipWriteInFileInZip(zipfile, data, (unsigned int) size_written);
+
+        if (error < 0) {
+            LXW_ERROR("Error in writing member in the zipfile");
+            RETURN_ON_ZIP_ERROR(error, LXW_ERROR_ZIP_FILE_ADD);
+        }
+
+        data += size_written;
+        size -= size_written;
+    }
+
+    return _close_zip_member(true, crc, uncompressed_size);
+}
+
+/*
+ * Create the XLXS OPC package and report progress/cancellation.
  */
 uint8_t packager::create_package()
 {
     int8_t error;
 
+    parts_total = _count_parts();
+
+    error = _create_package();
+
+    /* Don't leave a partial xlsx file behind if the close was cancelled. */
+    if (error == LXW_ERROR_CLOSE_CANCELLED) {
+        zipClose(zipfile, NULL);
+        remove(filename.c_str());
+    }
+
+    return error;
+}
+
+/*
+ * Write the xml files that make up the XLXS OPC package.
+ */
+uint8_t packager::_create_package()
+{
+    int8_t error;
+
     error = _write_worksheet_files();
     RETURN_ON_ERROR(error);
 
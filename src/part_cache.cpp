@@ -0,0 +1,304 @@
+/*****************************************************************************
+ * part_cache - A cache of deflated xlsx package parts.
+ *
+ * Used in conjunction with the libxlsxwriter library.
+ *
+ * Copyright 2014-2016, John McNamara, jmcnamara@cpan.org. See LICENSE.txt.
+ *
+ */
+
+#include <string.h>
+#include <zlib.h>
+#include <xlsxwriter/part_cache.hpp>
+#include <xlsxwriter/hash_table.hpp>
+
+#ifndef DEF_MEM_LEVEL
+#define DEF_MEM_LEVEL 8
+#endif
+
+namespace xlsxwriter {
+
+/*****************************************************************************
+ *
+ * Private functions.
+ *
+ ****************************************************************************/
+
+/*
+ * Drop the least recently used parts until the cache fits in max_size.
+ */
+void part_cache::_evict(size_t max_size)
+{
+    while (used_bytes > max_size && !lru.empty()) {
+        const entry& cached = lru.back();
+
+        used_bytes -= cached.size();
+        index.erase(cached.member->hash);
+        lru.pop_back();
+        eviction_count++;
+    }
+}
+
+/*****************************************************************************
+ *
+ * Public functions.
+ *
+ ****************************************************************************/
+
+part_cache::part_cache(size_t max_size)
+    : max_bytes(max_size)
+    , used_bytes(0)
+    , hit_count(0)
+    , miss_count(0)
+    , eviction_count(0)
+{
+}
+
+part_cache& part_cache::global()
+{
+    static part_cache cache;
+    return cache;
+}
+
+/*
+ * Raw deflate a part, with the same settings that minizip uses for the other
+ * members of the package.
+ */
+part_cache_member_ptr part_cache::_deflate(const char *data, size_t size,
+                                           uint64_t hash, uint32_t crc)
+{
+    std::shared_ptr<part_cache_member> member = std::make_shared<part_cache_member>();
+    z_stream stream;
+    int err;
+
+    memset(&stream, 0, sizeof(stream));
+
+    err = deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                       -MAX_WBITS, DEF_MEM_LEVEL, Z_DEFAULT_STRATEGY);
+    if (err != Z_OK)
+        return part_cache_member_ptr();
+
+    member->deflated.resize(deflateBound(&stream, (uLong) size));
+
+    stream.next_in = (Bytef *) data;
+    stream.avail_in = (uInt) size;
+    stream.next_out = member->deflated.data();
+    stream.avail_out = (uInt) member->deflated.size();
+
+    err = deflate(&stream, Z_FINISH);
+    deflateEnd(&stream);
+
+    if (err != Z_STREAM_END)
+        return part_cache_member_ptr();
+
+    member->deflated.resize(stream.total_out);
+    member->hash = hash;
+    member->crc32 = crc;
+    member->uncompressed_size = size;
+
+    return member;
+}
+
+/*
+ * Deflate a part without adding it to a cache.
+ */
+part_cache_member_ptr part_cache::compress(const char *data, size_t size)
+{
+    if (size >= UINT32_MAX)
+        return part_cache_member_ptr();
+
+    return _deflate(data, size, lxw_hash_bytes(data, size),
+                    (uint32_t) crc32(0L, (const Bytef *) data, (uInt) size));
+}
+
+/*
+ * Deflate a spooled part, reading it back in chunks if it has been spilled
+ * to a tmpfile.
+ */
+part_cache_member_ptr part_cache::compress(spool& part)
+{
+    std::shared_ptr<part_cache_member> member;
+    char buffer[LXW_PART_CACHE_BUFFER_SIZE];
+    uint64_t hash = lxw_hash_bytes(NULL, 0);
+    uint32_t crc = 0;
+    size_t size_read;
+    size_t used;
+    z_stream stream;
+    int flush;
+    int err;
+
+    if (part.in_memory())
+        return compress(part.data(), part.size());
+
+    member = std::make_shared<part_cache_member>();
+    memset(&stream, 0, sizeof(stream));
+
+    err = deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                       -MAX_WBITS, DEF_MEM_LEVEL, Z_DEFAULT_STRATEGY);
+    if (err != Z_OK)
+        return part_cache_member_ptr();
+
+    part.rewind();
+
+    do {
+        size_read = part.read(buffer, LXW_PART_CACHE_BUFFER_SIZE);
+
+        hash = lxw_hash_bytes(buffer, size_read, hash);
+        crc = (uint32_t) crc32(crc, (const Bytef *) buffer, (uInt) size_read);
+
+        stream.next_in = (Bytef *) buffer;
+        stream.avail_in = (uInt) size_read;
+        flush = size_read ? Z_NO_FLUSH : Z_FINISH;
+
+        /* Deflate until the input is used and the output is drained. As in
+         * minizip, Z_BUF_ERROR only means that no progress was possible,
+         * which happens when the last output chunk was filled exactly. */
+        do {
+            used = member->deflated.size();
+            member->deflated.resize(used + LXW_PART_CACHE_BUFFER_SIZE);
+
+            stream.next_out = member->deflated.data() + used;
+            stream.avail_out = LXW_PART_CACHE_BUFFER_SIZE;
+
+            err = deflate(&stream, flush);
+
+            if (err == Z_BUF_ERROR)
+                err = Z_OK;
+
+            member->deflated.resize(used + LXW_PART_CACHE_BUFFER_SIZE
+                                    - stream.avail_out);
+        } while ((stream.avail_in > 0 || stream.avail_out == 0)
+                 && err == Z_OK);
+
+    } while (size_read && err == Z_OK);
+
+    deflateEnd(&stream);
+
+    if (err != Z_STREAM_END)
+        return part_cache_member_ptr();
+
+    member->deflated.shrink_to_fit();
+    member->hash = hash;
+    member->crc32 = crc;
+    member->uncompressed_size = part.size();
+
+    return member;
+}
+
+/*
+ * Find a part in the cache, or compress and add it. A hit requires the data
+ * to match the data that the cached part was deflated from.
+ */
+part_cache_member_ptr part_cache::get(const char *data, size_t size)
+{
+    part_cache_member_ptr member;
+    uint64_t hash;
+    uint32_t crc;
+
+    /* Parts of 4GB or more are beyond the single call zlib API used here. */
+    if (size >= UINT32_MAX)
+        return member;
+
+    hash = lxw_hash_bytes(data, size);
+    crc = (uint32_t) crc32(0L, (const Bytef *) data, (uInt) size);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = index.find(hash);
+
+        if (it != index.end()) {
+            const entry& cached = *it->second;
+
+            if (cached.member->crc32 == crc && cached.data.size() == size
+                && memcmp(cached.data.data(), data, size) == 0) {
+                lru.splice(lru.begin(), lru, it->second);
+                hit_count++;
+                return cached.member;
+            }
+        }
+
+        miss_count++;
+    }
+
+    /* Compress outside the lock so other workbooks aren't held up. */
+    member = _deflate(data, size, hash, crc);
+    if (!member)
+        return member;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (member->deflated.size() + size > max_bytes)
+        return member;
+
+    auto it = index.find(hash);
+    if (it != index.end()) {
+        used_bytes -= it->second->size();
+        lru.erase(it->second);
+        index.erase(it);
+    }
+
+    lru.push_front(entry());
+    lru.front().member = member;
+    lru.front().data.assign(data, data + size);
+    index[hash] = lru.begin();
+    used_bytes += lru.front().size();
+
+    _evict(max_bytes);
+
+    return member;
+}
+
+void part_cache::set_max_size(size_t max_size)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    max_bytes = max_size;
+    _evict(max_bytes);
+}
+
+size_t part_cache::max_size()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return max_bytes;
+}
+
+void part_cache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    lru.clear();
+    index.clear();
+    used_bytes = 0;
+}
+
+size_t part_cache::size()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return used_bytes;
+}
+
+size_t part_cache::count()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return lru.size();
+}
+
+uint64_t part_cache::hits()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return hit_count;
+}
+
+uint64_t part_cache::misses()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return miss_count;
+}
+
+uint64_t part_cache::evictions()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return eviction_count;
+}
+
+} // namespace xlsxwriter
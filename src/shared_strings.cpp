@@ -10,9 +10,11 @@
 #include <xlsxwriter/xmlwriter.hpp>
 #include <xlsxwriter/shared_strings.hpp>
 #include <xlsxwriter/utility.hpp>
+#include <xlsxwriter/hash_table.hpp>
 #include <ctype.h>
 #include <cctype>
 #include <cstring>
+#include <algorithm>
 
 
 namespace xlsxwriter {
@@ -93,9 +95,34 @@ void sst::_write_sst()
  */
 void sst::_write_sst_strings()
 {
-    for (const auto& sst_element : order_list) {
-        /* Write the si element. */
-        _write_si(sst_element->string);
+    uint32_t local_index;
+
+    if (!renumbered && on_disk) {
+        sst_shard *shard = shards[0].get();
+        std::string& string = shard->buffer;
+
+        /* The strings are in the spool in order so read it straight through. */
+        shard->disk->rewind();
+
+        for (const auto& element : shard->disk_strings) {
+            string.resize(element.length);
+            shard->disk->read(&string[0], element.length);
+
+            /* Write the si element. */
+            _write_si(string);
+        }
+    }
+    else if (!renumbered) {
+        for (const auto& string : shards[0]->strings) {
+            /* Write the si element. */
+            _write_si(string.str());
+        }
+    }
+    else {
+        for (const auto& index : order) {
+            sst_shard *shard = _get_shard(index, &local_index);
+            _write_si(shard->get(local_index));
+        }
     }
 }
 
@@ -122,40 +149,376 @@ void sst::assemble_xml_file()
  * Public functions.
  *
  ****************************************************************************/
+/*
+ * Create a new SST shard.
+ */
+sst_shard::sst_shard()
+    : string_count(0)
+    , block_used(LXW_SST_BLOCK_SIZE)
+    , mask(0)
+{
+}
+
+/*
+ * Copy a string into the arena. The block size is larger than LXW_STR_MAX so
+ * a string always fits in a single block.
+ */
+const char *sst_shard::_store_string(const std::string& string)
+{
+    size_t length = string.size();
+    char *data;
+
+    if (block_used + length > LXW_SST_BLOCK_SIZE) {
+        blocks.emplace_back(new char[LXW_SST_BLOCK_SIZE]);
+        block_used = 0;
+    }
+
+    data = blocks.back().get() + block_used;
+    block_used += length;
+
+    memcpy(data, string.data(), length);
+
+    return data;
+}
+
+/*
+ * The number of strings in the shard.
+ */
+uint32_t sst_shard::size() const
+{
+    if (disk)
+        return (uint32_t) disk_strings.size();
+
+    return (uint32_t) strings.size();
+}
+
+/*
+ * Get a copy of a string in the shard.
+ */
+std::string sst_shard::get(uint32_t index)
+{
+    if (!disk)
+        return strings[index].str();
+
+    const sst_disk_ref& element = disk_strings[index];
+    std::string string(element.length, '\0');
+
+    disk->read_at(element.offset, &string[0], element.length);
+
+    return string;
+}
+
+/*
+ * Compare a string with a string in the shard. The string of an on disk
+ * shard is only read back if the hash and length match.
+ */
+bool sst_shard::_equal(uint32_t index, const std::string& string, uint32_t hash)
+{
+    if (!disk) {
+        const sst_string_ref& existing = strings[index];
+
+        return existing.hash == hash && existing.length == string.size()
+               && memcmp(existing.data, string.data(), existing.length) == 0;
+    }
+
+    const sst_disk_ref& existing = disk_strings[index];
+
+    if (existing.hash != hash || existing.length != string.size())
+        return false;
+
+    buffer.resize(existing.length);
+
+    return disk->read_at(existing.offset, &buffer[0], existing.length)
+               == existing.length
+           && memcmp(buffer.data(), string.data(), existing.length) == 0;
+}
+
+/*
+ * Double the number of index slots and re-index the strings.
+ */
+void sst_shard::_grow()
+{
+    size_t num_slots = slots.empty() ? 1024 : slots.size() * 2;
+    uint32_t hash;
+    size_t slot;
+    size_t i;
+
+    slots.assign(num_slots, 0);
+    mask = num_slots - 1;
+
+    for (i = 0; i < size(); i++) {
+        hash = disk ? disk_strings[i].hash : strings[i].hash;
+
+        for (slot = hash & mask; slots[slot]; slot = (slot + 1) & mask)
+            ;
+
+        slots[slot] = (uint32_t) (i + 1);
+    }
+}
+
+/*
+ * Add a string to the shard, if it isn't already there, and return its
+ * index in the shard. Finding an existing string doesn't allocate any memory.
+ */
+uint32_t sst_shard::intern(const std::string& string, uint32_t hash)
+{
+    sst_string_ref element;
+    size_t slot;
+
+    /* Keep the load factor at or below 1/2. */
+    if (((size_t) size() + 1) * 2 > slots.size())
+        _grow();
+
+    for (slot = hash & mask; slots[slot]; slot = (slot + 1) & mask) {
+        if (_equal(slots[slot] - 1, string, hash))
+            return slots[slot] - 1;
+    }
+
+    /* Append a new string to the spool of an on disk shard. */
+    if (disk) {
+        sst_disk_ref disk_element;
+
+        disk_element.offset = disk->size();
+        disk_element.length = (uint32_t) string.size();
+        disk_element.hash = hash;
+
+        disk->write(string);
+        disk_strings.push_back(disk_element);
+        slots[slot] = (uint32_t) disk_strings.size();
+
+        return (uint32_t) disk_strings.size() - 1;
+    }
+
+    /* Add a new string to the arena and the insertion order list. */
+    element.data = _store_string(string);
+    element.length = (uint32_t) string.size();
+    element.hash = hash;
+
+    strings.push_back(element);
+    slots[slot] = (uint32_t) strings.size();
+
+    return (uint32_t) strings.size() - 1;
+}
+
+/*
+ * Create a new SST object.
+ */
+sst::sst(bool concurrent, bool by_frequency, bool on_disk,
+         const std::string& tmpdir, size_t spool_threshold)
+    : string_count(0)
+    , unique_count(0)
+    , concurrent(concurrent)
+    , by_frequency(by_frequency)
+    , on_disk(on_disk)
+    , renumbered(concurrent || by_frequency)
+    , shard_bits(concurrent ? LXW_SST_SHARD_BITS : 0)
+    , shard_mask((1U << shard_bits) - 1)
+    , saved_string_count(0)
+{
+    uint32_t i;
+
+    for (i = 0; i <= shard_mask; i++) {
+        shards.emplace_back(new sst_shard());
+
+        if (on_disk)
+            shards.back()->disk.reset(new spool(tmpdir, spool_threshold));
+    }
+}
+
+/*
+ * Get the shard of a string id and the index of the string in the shard.
+ */
+sst_shard *sst::_get_shard(uint32_t index, uint32_t *local_index)
+{
+    *local_index = index >> shard_bits;
+
+    return shards[index & shard_mask].get();
+}
+
+/*
+ * Add a string to the SST SharedString table, if it isn't already there, and
+ * return it's index. The string isn't counted as written to a cell.
+ */
+uint32_t sst::intern(const std::string& string)
+{
+    uint64_t hash = lxw_hash_bytes(string.data(), string.size());
+    uint32_t shard_index;
+    sst_shard *shard;
+
+    if (!concurrent)
+        return shards[0]->intern(string, (uint32_t) hash);
+
+    /* The low bits of the hash are used by the shard index, so pick the
+     * shard with the high bits. */
+    shard_index = (uint32_t) (hash >> 32) & shard_mask;
+    shard = shards[shard_index].get();
+
+    std::lock_guard<std::mutex> lock(shard->mutex);
+
+    return (shard->intern(string, (uint32_t) hash) << shard_bits) | shard_index;
+}
+
 /*
  * Add to or find a string in the SST SharedString table and return it's index.
  */
-sst_element *sst::get_sst_index(const std::string& string)
+uint32_t sst::get_sst_index(const std::string& string)
 {
-    std::shared_ptr<sst_element> element = std::make_shared<sst_element>();
+    uint32_t index = intern(string);
 
-    /* Create potential new element with the string and its index. */
-    element->index = unique_count;
-    element->string = string;
+    add_reference(index);
 
-    /* Try to insert it and see whether we already have that string. */
-    //existing_element = RB_INSERT(sst_rb_tree, sst->rb_tree, element);
+    return index;
+}
 
-    /* If existing_element is not NULL, then it already existed. */
-    /* Free new created element. */
-    auto it = strings.insert(element) ;
-    if (it.second == false) {
-        string_count++;
-        return it.first->get();
+/*
+ * Check if an index refers to a string in the table.
+ */
+bool sst::has_string(uint32_t index)
+{
+    uint32_t local_index;
+    sst_shard *shard = _get_shard(index, &local_index);
+
+    if (!concurrent)
+        return local_index < shard->size();
+
+    std::lock_guard<std::mutex> lock(shard->mutex);
+
+    return local_index < shard->size();
+}
+
+/*
+ * Count a write of an interned string to a cell.
+ */
+void sst::add_reference(uint32_t index)
+{
+    uint32_t local_index;
+    sst_shard *shard = _get_shard(index, &local_index);
+
+    if (!concurrent) {
+        shard->string_count++;
+        return;
     }
 
-    /* If it didn't exist, also add it to the insertion order linked list. */
-    order_list.push_back(element);
+    std::lock_guard<std::mutex> lock(shard->mutex);
 
-    /* Update SST string counts. */
-    string_count++;
-    unique_count++;
-    return element.get();
+    shard->string_count++;
 }
 
-bool sst_element::equals(const std::shared_ptr<sst_element> &lhs, const std::shared_ptr<sst_element> &rhs)
+/*
+ * Get a string from the table by index.
+ */
+std::string sst::get_string(uint32_t index)
 {
-    return lhs->string == rhs->string;
+    uint32_t local_index;
+    sst_shard *shard = _get_shard(index, &local_index);
+
+    if (!concurrent)
+        return shard->get(local_index);
+
+    std::lock_guard<std::mutex> lock(shard->mutex);
+
+    return shard->get(local_index);
+}
+
+/*
+ * Returns LXW_ERROR_CREATING_TMPFILE if the strings of an on disk table
+ * couldn't be written to or read from their tmpfiles.
+ */
+uint8_t sst::error()
+{
+    for (const auto& shard : shards) {
+        if (shard->disk && shard->disk->error())
+            return shard->disk->error();
+    }
+
+    return LXW_NO_ERROR;
+}
+
+/*
+ * Renumber the strings when the workbook is saved, leaving out the strings
+ * that no cell uses. Used once strings are interned without being written.
+ */
+void sst::drop_unused_strings()
+{
+    if (!renumbered)
+        renumbered = true;
+}
+
+/*
+ * Start numbering the strings of a renumbered table.
+ */
+void sst::clear_order()
+{
+    order.clear();
+
+    for (const auto& shard : shards) {
+        shard->saved_final_index.swap(shard->final_index);
+        shard->final_index.assign(shard->size(), LXW_SST_INVALID_INDEX);
+        shard->uses.assign(shard->size(), 0);
+    }
+}
+
+/*
+ * Give a string the next position in sharedStrings.xml if it doesn't have
+ * one yet. This is called for the string cells in worksheet order, when no
+ * other threads are using the table.
+ */
+void sst::add_to_order(uint32_t index)
+{
+    uint32_t local_index;
+    sst_shard *shard = _get_shard(index, &local_index);
+    uint32_t& final_index = shard->final_index[local_index];
+
+    if (final_index == LXW_SST_INVALID_INDEX) {
+        final_index = (uint32_t) order.size();
+        order.push_back(index);
+    }
+
+    shard->uses[local_index]++;
+}
+
+/*
+ * Update the string counts before the table is written.
+ */
+void sst::finalize()
+{
+    uint32_t local_index;
+    size_t i;
+
+    string_count = 0;
+
+    for (const auto& shard : shards)
+        string_count += shard->string_count;
+
+    /* Put the most used strings first. The sort is stable so that strings
+     * with the same number of uses keep the order that the cells use them. */
+    if (by_frequency) {
+        std::stable_sort(order.begin(), order.end(),
+                         [this](uint32_t index1, uint32_t index2) {
+            uint32_t local1 = index1 >> shard_bits;
+            uint32_t local2 = index2 >> shard_bits;
+
+            return shards[index1 & shard_mask]->uses[local1]
+                   > shards[index2 & shard_mask]->uses[local2];
+        });
+    }
+    else if (renumbered && !concurrent) {
+        /* A table that is only renumbered to leave out unused strings keeps
+         * the order that the strings were added in. */
+        std::sort(order.begin(), order.end());
+    }
+
+    if (by_frequency || (renumbered && !concurrent)) {
+        for (i = 0; i < order.size(); i++) {
+            sst_shard *shard = _get_shard(order[i], &local_index);
+            shard->final_index[local_index] = (uint32_t) i;
+        }
+    }
+
+    if (renumbered)
+        unique_count = (uint32_t) order.size();
+    else
+        unique_count = shards[0]->size();
 }
 
 } // namespace xlsxwriter
@@ -0,0 +1,250 @@
+/*****************************************************************************
+ * spool - A memory backed output buffer for the xlsx XML parts.
+ *
+ * Used in conjunction with the libxlsxwriter library.
+ *
+ * Copyright 2014-2016, John McNamara, jmcnamara@cpan.org. See LICENSE.txt.
+ *
+ */
+
+#include <stdarg.h>
+#include <string.h>
+#include <xlsxwriter/spool.hpp>
+#include <xlsxwriter/utility.hpp>
+
+#define LXW_SPOOL_PRINT_SIZE 512
+
+#ifdef _MSC_VER
+#define lxw_fseek _fseeki64
+#else
+#define lxw_fseek fseeko
+#endif
+
+namespace xlsxwriter {
+
+/*****************************************************************************
+ *
+ * Private functions.
+ *
+ ****************************************************************************/
+
+/*
+ * Move the in memory buffer to a tmpfile. Subsequent writes go to the file.
+ */
+uint8_t spool::_spill()
+{
+    file = lxw_tmpfile(tmpdir.empty() ? NULL : tmpdir.c_str());
+    if (!file) {
+        err = LXW_ERROR_CREATING_TMPFILE;
+        return err;
+    }
+
+    if (!buffer.empty()
+        && fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size()) {
+        err = LXW_ERROR_CREATING_TMPFILE;
+        return err;
+    }
+
+    /* Release the memory held by the buffer. */
+    std::string().swap(buffer);
+
+    return LXW_NO_ERROR;
+}
+
+/*****************************************************************************
+ *
+ * Public functions.
+ *
+ ****************************************************************************/
+
+/*
+ * Create a new spool object.
+ */
+spool::spool(const std::string& tmpdir, size_t threshold)
+    : tmpdir(tmpdir)
+    , threshold(threshold)
+    , file(NULL)
+    , length(0)
+    , read_offset(0)
+    , reading(false)
+    , err(LXW_NO_ERROR)
+{
+    if (threshold == 0)
+        _spill();
+}
+
+spool::~spool()
+{
+    if (file)
+        fclose(file);
+}
+
+/*
+ * Append data to the spool, spilling to a tmpfile if the threshold is
+ * exceeded.
+ */
+void spool::write(const char *data, size_t size)
+{
+    if (err || size == 0)
+        return;
+
+    if (!file && buffer.size() + size > threshold) {
+        if (_spill())
+            return;
+    }
+
+    if (file) {
+        /* A read must be followed by a seek before the stream is written. */
+        if (reading) {
+            fseek(file, 0, SEEK_END);
+            reading = false;
+        }
+
+        if (fwrite(data, 1, size, file) != size) {
+            err = LXW_ERROR_CREATING_TMPFILE;
+            return;
+        }
+    }
+    else {
+        buffer.append(data, size);
+    }
+
+    length += size;
+}
+
+void spool::write(const std::string& data)
+{
+    write(data.data(), data.size());
+}
+
+/*
+ * Append printf() style formatted data to the spool.
+ */
+void spool::print(const char *format, ...)
+{
+    char stack_buffer[LXW_SPOOL_PRINT_SIZE];
+    va_list args;
+    int size;
+
+    va_start(args, format);
+    size = vsnprintf(stack_buffer, LXW_SPOOL_PRINT_SIZE, format, args);
+    va_end(args);
+
+    /* Report a formatting error like a failed write, since the data is
+     * lost either way. */
+    if (size < 0) {
+        err = LXW_ERROR_CREATING_TMPFILE;
+        return;
+    }
+
+    if (size < LXW_SPOOL_PRINT_SIZE) {
+        write(stack_buffer, size);
+    }
+    else {
+        /* Rare case of a long string, such as a large inline string cell. */
+        std::string heap_buffer(size + 1, '\0');
+
+        va_start(args, format);
+        if (vsnprintf(&heap_buffer[0], size + 1, format, args) < 0)
+            err = LXW_ERROR_CREATING_TMPFILE;
+        va_end(args);
+
+        if (err)
+            return;
+
+        write(heap_buffer.data(), size);
+    }
+}
+
+/*
+ * Prepare the spool to be read back from the start.
+ */
+void spool::rewind()
+{
+    read_offset = 0;
+
+    if (file) {
+        fflush(file);
+        ::rewind(file);
+        reading = true;
+    }
+}
+
+/*
+ * Read back up to size bytes of spooled data. Returns 0 at the end.
+ */
+size_t spool::read(char *data, size_t size)
+{
+    size_t read_size;
+
+    if (file)
+        return fread(data, 1, size, file);
+
+    read_size = buffer.size() - read_offset;
+    if (read_size > size)
+        read_size = size;
+
+    memcpy(data, buffer.data() + read_offset, read_size);
+    read_offset += read_size;
+
+    return read_size;
+}
+
+/*
+ * Read back up to size bytes of spooled data from an offset. Call rewind()
+ * before using read() again afterwards.
+ */
+size_t spool::read_at(size_t offset, char *data, size_t size)
+{
+    if (offset >= length)
+        return 0;
+
+    if (size > length - offset)
+        size = length - offset;
+
+    if (file) {
+        reading = true;
+
+        if (lxw_fseek(file, offset, SEEK_SET))
+            return 0;
+
+        return fread(data, 1, size, file);
+    }
+
+    memcpy(data, buffer.data() + offset, size);
+
+    return size;
+}
+
+/*
+ * Check if the spooled data is still held in memory, in which case it can be
+ * accessed directly via data().
+ */
+bool spool::in_memory() const
+{
+    return file == NULL;
+}
+
+const char *spool::data() const
+{
+    return buffer.data();
+}
+
+/*
+ * The total number of bytes written to the spool.
+ */
+size_t spool::size() const
+{
+    return length;
+}
+
+/*
+ * Returns LXW_ERROR_CREATING_TMPFILE if spilling to or writing the tmpfile
+ * failed at any point, or if print() couldn't format its data.
+ */
+uint8_t spool::error() const
+{
+    return err;
+}
+
+} // namespace xlsxwriter
@@ -47,7 +47,7 @@ void styles::_write_style_sheet()
 /*
  * Write the <numFmt> element.
  */
-void styles::_write_num_fmt(uint16_t num_fmt_id, char* format_code)
+void styles::_write_num_fmt(uint16_t num_fmt_id, const std::string& format_code)
 {
     xml_attribute_list attributes = {
         {"numFmtId", std::to_string(num_fmt_id)},
@@ -72,14 +72,8 @@ void styles::_write_num_fmts()
     lxw_xml_start_tag("numFmts", attributes);
 
     /* Write the numFmts elements. */
-    for (const auto& format : xf_formats) {
-
-        /* Ignore built-in number formats, i.e., < 164. */
-        if (format->num_format_index < 164)
-            continue;
-
-        _write_num_fmt(format->num_format_index, format->num_format);
-    }
+    for (const auto& num_format : *num_formats)
+        _write_num_fmt(num_format.second, num_format.first);
 
     lxw_xml_end_tag("numFmts");
 }
@@ -258,10 +252,8 @@ void styles::_write_fonts()
 
     lxw_xml_start_tag("fonts", attributes);
 
-    for (const auto& format : xf_formats) {
-        if (format->has_font)
-            _write_font(format);
-    }
+    for (const auto& font : *fonts)
+        _write_font(font.second);
 
     lxw_xml_end_tag("fonts");
 }
@@ -378,9 +370,10 @@ void styles::_write_fills()
     _write_default_fill("none");
     _write_default_fill("gray125");
 
-    for (const auto& format : xf_formats) {
-        if (format->has_fill)
-            _write_fill(format);
+    for (const auto& fill : *fills) {
+        /* The default fills above don't have a format. */
+        if (fill.second)
+            _write_fill(fill.second);
     }
 
     lxw_xml_end_tag("fills");
@@ -492,10 +485,8 @@ void styles::_write_borders()
 
     lxw_xml_start_tag("borders", attributes);
 
-    for (const auto& format : xf_formats) {
-        if (format->has_border)
-            _write_border(format);
-    }
+    for (const auto& border : *borders)
+        _write_border(border.second);
 
     lxw_xml_end_tag("borders");
 }
@@ -0,0 +1,136 @@
+/* Generated by gen_theme from theme_strs.h. Do not edit. */
+
+#include <xlsxwriter/theme.hpp>
+
+namespace xlsxwriter {
+
+const unsigned char theme_deflated[] = {
+    0xed, 0x59, 0x4d, 0x8f, 0xd3, 0x46, 0x18, 0xbe, 0xf3, 0x2b, 0x46, 0xbe,
+    0x83, 0xe3, 0xc4, 0x0e, 0xd9, 0x15, 0x59, 0xb4, 0xc9, 0x26, 0xd0, 0xc2,
+    0xc2, 0x6a, 0x37, 0x50, 0x71, 0x9c, 0xd8, 0x13, 0x7b, 0xc8, 0xd8, 0x63,
+    0xcd, 0x4c, 0x76, 0xc9, 0xad, 0x82, 0x63, 0xa5, 0x4a, 0x55, 0x69, 0xd5,
+    0x4b, 0xa5, 0xde, 0x7a, 0xa8, 0xda, 0x22, 0x81, 0xd4, 0x0b, 0xfd, 0x35,
+    0xdb, 0x52, 0xb5, 0x54, 0xe2, 0x2f, 0xf4, 0xf5, 0x47, 0x92, 0xf1, 0x66,
+    0xb2, 0x64, 0x61, 0xab, 0x16, 0x41, 0x0e, 0x89, 0x67, 0xfc, 0xbc, 0xdf,
+    0x1f, 0x7e, 0xc7, 0xb9, 0x72, 0xf5, 0x41, 0xcc, 0xd0, 0x21, 0x11, 0x92,
+    0xf2, 0xa4, 0x6d, 0x39, 0x97, 0x6a, 0x16, 0x22, 0x89, 0xcf, 0x03, 0x9a,
+    0x84, 0x6d, 0xeb, 0xce, 0xa0, 0x7f, 0xb1, 0x65, 0x21, 0xa9, 0x70, 0x12,
+    0x60, 0xc6, 0x13, 0xd2, 0xb6, 0xa6, 0x44, 0x5a, 0x57, 0xb7, 0x2e, 0x5c,
+    0xc1, 0x9b, 0x2a, 0x22, 0x31, 0x41, 0x40, 0x9e, 0xc8, 0x4d, 0xdc, 0xb6,
+    0x22, 0xa5, 0xd2, 0x4d, 0xdb, 0x96, 0x3e, 0x6c, 0x63, 0x79, 0x89, 0xa7,
+    0x24, 0x81, 0x7b, 0x23, 0x2e, 0x62, 0xac, 0x60, 0x29, 0x42, 0x3b, 0x10,
+    0xf8, 0x08, 0xd8, 0xc6, 0xcc, 0xae, 0xd7, 0x6a, 0x4d, 0x3b, 0xc6, 0x34,
+    0xb1, 0x50, 0x82, 0x63, 0xe0, 0x7a, 0x7b, 0x34, 0xa2, 0x3e, 0x41, 0x83,
+    0x8c, 0xa5, 0xb5, 0x35, 0x63, 0xde, 0x63, 0xf0, 0x95, 0x28, 0x99, 0x6d,
+    0xf8, 0x4c, 0x1c, 0xf8, 0xb9, 0x44, 0x9d, 0x22, 0xc7, 0x06, 0x63, 0x27,
+    0xfb, 0x91, 0x53, 0xd9, 0x65, 0x02, 0x1d, 0x62, 0xd6, 0xb6, 0x40, 0x4e,
+    0xc0, 0x8f, 0x06, 0xe4, 0x81, 0xb2, 0x10, 0xc3, 0x52, 0xc1, 0x8d, 0xb6,
+    0x55, 0xcb, 0x3f, 0x96, 0xbd, 0x75, 0xc5, 0x9e, 0x13, 0x31, 0xb5, 0x82,
+    0x56, 0xa3, 0xeb, 0xe7, 0x9f, 0x92, 0xae, 0x24, 0x08, 0xc6, 0xf5, 0x9c,
+    0x4e, 0x84, 0xc3, 0x39, 0xa1, 0xd3, 0x77, 0x37, 0x2e, 0xef, 0xcc, 0xf9,
+    0xd7, 0x0b, 0xfe, 0xcb, 0xb8, 0x5e, 0xaf, 0xd7, 0xed, 0x39, 0x73, 0x7e,
+    0x39, 0x00, 0xfb, 0x3e, 0x58, 0xea, 0x2c, 0x61, 0xdd, 0x7e, 0xcb, 0xe9,
+    0xcc, 0x78, 0x6a, 0xa0, 0xe2, 0x72, 0x99, 0x77, 0xb7, 0xe6, 0xd5, 0xdc,
+    0x2a, 0x5e, 0xe3, 0xdf, 0x58, 0xc2, 0x6f, 0x74, 0x3a, 0x1d, 0x6f, 0xa3,
+    0x82, 0x6f, 0x2c, 0xf0, 0xee, 0x12, 0xbe, 0x55, 0x6b, 0xba, 0xdb, 0xf5,
+    0x0a, 0xde, 0x5d, 0xe0, 0xbd, 0x65, 0xfd, 0x3b, 0xdb, 0xdd, 0x6e, 0xb3,
+    0x82, 0xf7, 0x16, 0xf8, 0xe6, 0x12, 0xbe, 0x7f, 0x79, 0xa3, 0xe9, 0x56,
+    0xf1, 0x39, 0x28, 0x62, 0x34, 0x19, 0x2f, 0xa1, 0xb3, 0x78, 0xce, 0x23,
+    0x33, 0x87, 0x8c, 0x38, 0xbb, 0x6e, 0x84, 0xb7, 0x00, 0xde, 0x9a, 0x25,
+    0xc0, 0x02, 0x65, 0x6b, 0xd9, 0x55, 0xd0, 0x27, 0x6a, 0x55, 0xae, 0xc5,
+    0xf8, 0x3e, 0x17, 0x7d, 0x00, 0xe4, 0xc1, 0xc5, 0x8a, 0x26, 0x48, 0x4d,
+    0x53, 0x32, 0xc2, 0x3e, 0xe0, 0xba, 0x38, 0x1e, 0x0a, 0x8a, 0x33, 0x01,
+    0x78, 0x93, 0x60, 0xed, 0x4e, 0xb1, 0xe5, 0xcb, 0xa5, 0xad, 0x4c, 0x16,
+    0x92, 0xbe, 0xa0, 0xa9, 0x6a, 0x5b, 0x1f, 0xa7, 0x18, 0x2a, 0x62, 0x01,
+    0x79, 0xf5, 0xfc, 0xc7, 0x57, 0xcf, 0x9f, 0xa2, 0x57, 0xcf, 0x9f, 0x1c,
+    0x3f, 0x7c, 0x76, 0xfc, 0xf0, 0x97, 0xe3, 0x47, 0x8f, 0x8e, 0x1f, 0xfe,
+    0x6c, 0x20, 0xbc, 0x8e, 0x93, 0x50, 0x27, 0x7c, 0xf9, 0xfd, 0x17, 0x7f,
+    0x7f, 0xfb, 0x29, 0xfa, 0xeb, 0xe9, 0x77, 0x2f, 0x1f, 0x7f, 0x65, 0xc6,
+    0x4b, 0x1d, 0xff, 0xfb, 0x4f, 0x9f, 0xfd, 0xf6, 0xeb, 0x97, 0x66, 0xa0,
+    0xd2, 0x81, 0x2f, 0xbe, 0x7e, 0xf2, 0xc7, 0xb3, 0x27, 0x2f, 0xbe, 0xf9,
+    0xfc, 0xcf, 0x1f, 0x1e, 0x1b, 0xe0, 0xdb, 0x02, 0x0f, 0x75, 0xf8, 0x80,
+    0xc6, 0x44, 0xa2, 0x5b, 0xe4, 0x08, 0xed, 0xf3, 0x18, 0x6c, 0x33, 0x08,
+    0x20, 0x43, 0x71, 0x36, 0x8a, 0x41, 0x84, 0x69, 0x85, 0x02, 0x47, 0x80,
+    0x34, 0x00, 0x7b, 0x2a, 0xaa, 0x00, 0x6f, 0x4d, 0x31, 0x33, 0xe1, 0x3a,
+    0xa4, 0xea, 0xbc, 0xbb, 0x02, 0x1a, 0x80, 0x09, 0x78, 0x6d, 0x72, 0xbf,
+    0xa2, 0xeb, 0x41, 0x24, 0x26, 0x8a, 0x1a, 0x80, 0x37, 0xa2, 0xb8, 0x02,
+    0xdc, 0xe5, 0x9c, 0x75, 0xb8, 0x30, 0x9a, 0x73, 0x23, 0x93, 0xa5, 0x9b,
+    0x33, 0x49, 0x42, 0xb3, 0x70, 0x31, 0xd1, 0x71, 0xfb, 0x18, 0x1f, 0x9a,
+    0x64, 0x77, 0x4f, 0x84, 0xb6, 0x37, 0x49, 0x21, 0x93, 0xa9, 0x89, 0x65,
+    0x37, 0x22, 0x15, 0x35, 0xf7, 0x18, 0x44, 0x1b, 0x87, 0x24, 0x21, 0x0a,
+    0x65, 0xf7, 0xf8, 0x98, 0x10, 0x03, 0xd9, 0x3d, 0x4a, 0x2b, 0x7e, 0xdd,
+    0xa5, 0xbe, 0xe0, 0x92, 0x8f, 0x14, 0xba, 0x47, 0x51, 0x07, 0x53, 0xa3,
+    0x4b, 0x06, 0x74, 0xa8, 0xcc, 0x44, 0xd7, 0x69, 0x0c, 0x71, 0x99, 0x9a,
+    0x14, 0x84, 0x50, 0x57, 0x7c, 0xb3, 0x7b, 0x17, 0x75, 0x38, 0x33, 0xb1,
+    0xdf, 0x21, 0x87, 0x55, 0x24, 0x14, 0x04, 0x66, 0x26, 0x96, 0x84, 0x55,
+    0xdc, 0x78, 0x0d, 0x4f, 0x14, 0x8e, 0x8d, 0x1a, 0xe3, 0x98, 0xe9, 0xc8,
+    0x9b, 0x58, 0x45, 0x26, 0x25, 0x0f, 0xa6, 0xc2, 0xaf, 0x38, 0x5c, 0x2a,
+    0x88, 0x74, 0x48, 0x18, 0x47, 0xbd, 0x80, 0x48, 0x69, 0xa2, 0xb9, 0x2d,
+    0xa6, 0x15, 0x75, 0x6f, 0x60, 0xe8, 0x44, 0xc6, 0xb0, 0xef, 0xb2, 0x69,
+    0x5c, 0x45, 0x0a, 0x45, 0xc7, 0x26, 0xe4, 0x4d, 0xcc, 0xb9, 0x8e, 0xdc,
+    0xe1, 0xe3, 0x6e, 0x84, 0xe3, 0xd4, 0xa8, 0x33, 0x4d, 0x22, 0x1d, 0xfb,
+    0x91, 0x1c, 0x43, 0x8a, 0x62, 0xb4, 0xc7, 0x95, 0x51, 0x09, 0x5e, 0xad,
+    0x90, 0x6c, 0x0d, 0x71, 0xc0, 0xc9, 0xca, 0x70, 0xdf, 0xa5, 0x44, 0x9d,
+    0xad, 0xac, 0xef, 0xd0, 0x30, 0x32, 0x27, 0x48, 0x76, 0x67, 0x22, 0xca,
+    0xae, 0x5d, 0xe9, 0xbf, 0x31, 0x4d, 0x4e, 0x6b, 0xc6, 0x8c, 0x42, 0x37,
+    0xfe, 0xd0, 0x8c, 0x67, 0xf0, 0x6d, 0x78, 0x34, 0x99, 0x4a, 0xe2, 0x64,
+    0x0b, 0x5e, 0x85, 0x7b, 0x07, 0x1b, 0xef, 0x0e, 0x9e, 0x24, 0x7b, 0x04,
+    0x72, 0xfd, 0x43, 0xdf, 0xfd, 0xd0, 0x77, 0xdf, 0xc7, 0xbe, 0xbb, 0xaa,
+    0x96, 0xd7, 0xed, 0xb6, 0x8b, 0x06, 0x6b, 0xeb, 0x73, 0x71, 0xce, 0x2f,
+    0x5e, 0x39, 0x24, 0x8f, 0x28, 0x63, 0x07, 0x6a, 0xca, 0xc8, 0x4d, 0x99,
+    0xb7, 0x66, 0x09, 0x4a, 0x07, 0x7d, 0xd8, 0xcc, 0x17, 0x39, 0xd1, 0x7c,
+    0x26, 0x4f, 0x23, 0xb8, 0x2c, 0xc5, 0x55, 0x70, 0xa1, 0xc0, 0xf9, 0x35,
+    0x12, 0x5c, 0x7d, 0x42, 0x55, 0x74, 0x10, 0xe1, 0x14, 0xc4, 0x38, 0xb9,
+    0x84, 0x50, 0x96, 0xac, 0x43, 0x89, 0x52, 0x2e, 0xe1, 0x24, 0x60, 0xad,
+    0xe4, 0x9d, 0x1f, 0x27, 0x29, 0x18, 0x9f, 0xef, 0x79, 0xb3, 0x33, 0x20,
+    0xa0, 0xb1, 0xda, 0xe5, 0x41, 0xb1, 0xdd, 0xd0, 0xcf, 0x86, 0x73, 0x36,
+    0xf9, 0x2a, 0x94, 0xba, 0xa0, 0x46, 0xc6, 0x60, 0x5d, 0x61, 0x8d, 0xcb,
+    0x6f, 0x27, 0xcc, 0x29, 0x80, 0x6b, 0x4a, 0x73, 0x3c, 0xb3, 0x34, 0xef,
+    0x54, 0x69, 0xb6, 0xe6, 0x4d, 0xa8, 0x06, 0x84, 0xb3, 0x83, 0xbf, 0xd3,
+    0xac, 0x17, 0xa2, 0x21, 0x63, 0x30, 0x23, 0x41, 0xe6, 0xf7, 0x82, 0xc1,
+    0x2c, 0x2c, 0xe7, 0x1e, 0x22, 0x19, 0xe1, 0x80, 0x94, 0x31, 0x72, 0x8c,
+    0x86, 0x38, 0x8d, 0x35, 0xdd, 0xd6, 0x7a, 0xbd, 0xd7, 0x34, 0x69, 0x1b,
+    0x8d, 0xb7, 0x93, 0xb6, 0x4e, 0x90, 0x74, 0x71, 0xee, 0x0a, 0x71, 0xde,
+    0x39, 0x44, 0xa9, 0xb6, 0x14, 0x25, 0x7b, 0xb9, 0x1c, 0x59, 0x52, 0x5d,
+    0xa1, 0x23, 0xd0, 0xca, 0xab, 0x7b, 0x16, 0xf2, 0x71, 0xda, 0xb6, 0x46,
+    0x30, 0x49, 0xc1, 0x65, 0x9c, 0x02, 0x3f, 0x99, 0x35, 0x20, 0xcc, 0xc2,
+    0xa4, 0x6d, 0xf9, 0xaa, 0x34, 0xe5, 0xb5, 0xc5, 0x7c, 0xd2, 0x60, 0x73,
+    0x5a, 0x3a, 0xb5, 0x95, 0x06, 0x57, 0x44, 0xa4, 0x42, 0xaa, 0x1d, 0x2c,
+    0xa3, 0x82, 0x2a, 0xbf, 0x35, 0x7b, 0x75, 0x92, 0x2c, 0xf4, 0xaf, 0x7b,
+    0x6e, 0xe6, 0x87, 0xf3, 0x31, 0xc0, 0xd0, 0x8d, 0xd6, 0xd3, 0xa2, 0xd1,
+    0x72, 0xfe, 0x43, 0x2d, 0xec, 0x93, 0xa1, 0x25, 0xa3, 0x11, 0xf1, 0xd5,
+    0x8a, 0x9d, 0xc5, 0xb2, 0xbc, 0xc7, 0x27, 0x8a, 0x88, 0x83, 0x28, 0x38,
+    0x42, 0x43, 0x36, 0x11, 0xfb, 0x18, 0xf4, 0x76, 0x8b, 0xec, 0x0a, 0xa8,
+    0x84, 0x67, 0x46, 0x7d, 0xb6, 0x10, 0x50, 0xa1, 0x6e, 0x99, 0x78, 0xd5,
+    0xca, 0x2f, 0xab, 0xe0, 0xe4, 0x2b, 0x9a, 0xb2, 0x3a, 0x30, 0x4b, 0x23,
+    0x5c, 0xf6, 0xa4, 0x96, 0x16, 0xfb, 0x02, 0x9e, 0x5f, 0xcf, 0x75, 0xc8,
+    0x57, 0x9a, 0x7a, 0xf6, 0x0a, 0xdd, 0xdf, 0xd0, 0x94, 0xc6, 0x39, 0x9a,
+    0xe2, 0xbd, 0xbf, 0xa6, 0x64, 0x99, 0x0b, 0x63, 0x6b, 0x23, 0xc8, 0x0f,
+    0x54, 0x30, 0x06, 0x08, 0x8c, 0xb2, 0x1c, 0x6d, 0x5b, 0x5c, 0xa8, 0x88,
+    0x43, 0x17, 0x4a, 0x23, 0xea, 0xf7, 0x05, 0x0c, 0x0e, 0xb9, 0x2c, 0xd0,
+    0x0b, 0x41, 0x59, 0x64, 0x2a, 0x21, 0x96, 0xbd, 0x6f, 0xce, 0x74, 0x25,
+    0x87, 0x8b, 0xbe, 0x55, 0xf0, 0x28, 0x9a, 0x5c, 0x18, 0xa9, 0x7d, 0x1a,
+    0x22, 0x41, 0xa1, 0xd3, 0xa9, 0x48, 0x10, 0xb2, 0xa7, 0x4a, 0x3b, 0x5f,
+    0xc3, 0xcc, 0xa9, 0xeb, 0xcf, 0xd7, 0x19, 0xa3, 0xb2, 0xcf, 0xcc, 0xd5,
+    0x95, 0x69, 0xf1, 0x3b, 0x24, 0x87, 0x84, 0x0d, 0xb2, 0xea, 0x6d, 0x66,
+    0xf6, 0x5b, 0x28, 0x9a, 0x75, 0x93, 0xd2, 0x11, 0x39, 0xee, 0x64, 0xd0,
+    0x6c, 0x53, 0x75, 0x0d, 0xc3, 0xfe, 0xff, 0x78, 0xf2, 0x71, 0x57, 0x4c,
+    0x3e, 0xa7, 0x8f, 0x07, 0x0b, 0x41, 0xee, 0x59, 0x66, 0x11, 0x57, 0x6b,
+    0xfa, 0xda, 0xa3, 0x60, 0xe3, 0xed, 0x54, 0x38, 0xe3, 0xa3, 0xb6, 0x6e,
+    0xb6, 0xb8, 0xee, 0xad, 0xfd, 0xa8, 0x4d, 0xe1, 0xf0, 0x81, 0xb2, 0x2f,
+    0x68, 0xdc, 0x54, 0xf8, 0x6c, 0x31, 0xdf, 0x0e, 0xf8, 0x3e, 0x44, 0x1f,
+    0xcd, 0x27, 0x4a, 0x04, 0x89, 0x78, 0xb1, 0x55, 0x96, 0xdf, 0x7c, 0x73,
+    0x08, 0x3a, 0xb7, 0x34, 0xe3, 0x32, 0x56, 0xff, 0xee, 0x18, 0xb5, 0x08,
+    0x41, 0x6b, 0x45, 0xbc, 0xcf, 0x73, 0xf8, 0xd4, 0x9c, 0xdd, 0x58, 0xe1,
+    0xec, 0xd3, 0xc5, 0xbd, 0xb9, 0xb3, 0x3d, 0x83, 0xaf, 0xbd, 0xd3, 0x5d,
+    0x6d, 0x2f, 0x97, 0xa8, 0xad, 0x1d, 0x64, 0xf2, 0xd5, 0xd2, 0x1f, 0x4f,
+    0x7c, 0x78, 0x1f, 0x64, 0xef, 0xc0, 0x41, 0x69, 0xc2, 0x94, 0x2c, 0xde,
+    0x26, 0x3d, 0x80, 0xa3, 0x66, 0x77, 0xf6, 0x97, 0x01, 0xf0, 0xb1, 0x17,
+    0xa4, 0x5b, 0x17, 0xfe, 0x01,
+};
+
+const size_t theme_deflated_size = 1457;
+const size_t theme_uncompressed_size = 6995;
+const uint32_t theme_crc32 = 0x21efd83fUL;
+
+} // namespace xlsxwriter
@@ -1,21 +1,18 @@
-/*****************************************************************************
- * theme - A library for creating Excel XLSX theme files.
- *
- * Used in conjunction with the libxlsxwriter library.
+/*
+ * libxlsxwriter
  *
  * Copyright 2014-2016, John McNamara, jmcnamara@cpan.org. See LICENSE.txt.
  *
+ * theme_strs - The fixed XML of the theme1.xml part. It is shared by
+ *              theme.cpp and the build time theme compressor.
+ *
  */
-
-#include <string.h>
-
-#include <xlsxwriter/xmlwriter.hpp>
-#include <xlsxwriter/theme.hpp>
-#include <xlsxwriter/utility.hpp>
+#ifndef __LXW_THEME_STRS_H__
+#define __LXW_THEME_STRS_H__
 
 namespace xlsxwriter {
 
-const char *theme_strs[] = {
+static const char *theme_strs[] = {
     "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n",
     "<a:theme xmlns:a=\"http://schemas.openxmlformats.org/",
     "drawingml/2006/main\" name=\"Office Theme\">",
@@ -277,41 +274,6 @@ const char *theme_strs[] = {
     ""
 };
 
-/*
- * Forward declarations.
- */
-
-/*****************************************************************************
- *
- * XML functions.
- *
- ****************************************************************************/
-
-/* This library isn't a xmlwriter. */
-
-/*****************************************************************************
- *
- * XML file assembly functions.
- *
- ****************************************************************************/
-
-/*
- * Assemble and write the XML file.
- */
-void theme::assemble_xml_file()
-{
-    int i = 0;
-
-    while (strlen(theme_strs[i])) {
-        fprintf(file, "%s", theme_strs[i]);
-        i++;
-    }
-}
-
 } // namespace xlsxwriter
 
-/*****************************************************************************
- *
- * Public functions.
- *
- ****************************************************************************/
+#endif /* __LXW_THEME_STRS_H__ */
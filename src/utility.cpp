@@ -42,6 +42,9 @@ static const std::vector<std::string> error_strings = {
     "Worksheet row or column index out of range.",
     "Maximum number of worksheet URLs (65530) exceeded.",
     "Couldn't read image dimensions or DPI.",
+    "Workbook close was cancelled before the xlsx file was complete.",
+    "Workbook save() isn't supported in constant_memory mode.",
+    "Couldn't open an inserted image file to add it to the xlsx file.",
     "Unknown error number."
 };
 
@@ -14,7 +14,8 @@
 #include <xlsxwriter/hash_table.hpp>
 #include <iostream>
 #include <sstream>
-
+#include <thread>
+#include <tuple>
 
 namespace xlsxwriter {
 
@@ -29,236 +30,187 @@ void workbook::set_default_xf_indices()
 }
 
 /*
- * Iterate through the XF Format objects and give them an index to non-default
- * font elements.
+ * Give a format the index of its font element, adding the font to the table
+ * of unique fonts if it is new.
  */
-void workbook::_prepare_fonts()
+void workbook::_prepare_font(format_ptr format)
 {
+    auto result = unique_fonts.insert(format->get_font_key(), format);
 
-    hash_table<lxw_font_ptr, uint16_t> fonts;
-    uint16_t index = 0;
-
-    for (const auto& it : used_xf_formats.order_list) {
-        auto format = it.first;
-        lxw_font_ptr key(format->get_font_key());
-
-        if (key) {
-            /* Look up the format in the hash table. */
-            auto result = fonts.exists(key);
+    format->font_index = (uint16_t) unique_fonts.index(result.first);
+    format->has_font = result.second;
+}
 
-            if (result.second) {
-                /* Font has already been used. */
-                format->font_index = result.first.second;
-                format->has_font = false;
-                delete key;
-            }
-            else {
-                /* This is a new font. */
-                uint16_t font_index = index;
-                format->font_index = index;
-                format->has_font = true;
-                fonts.insert(key, font_index);
-                index++;
-            }
-        }
-    }
-    font_count = index;
+/*
+ * Give a format the index of its border element, adding the border to the
+ * table of unique borders if it is new.
+ */
+void workbook::_prepare_border(format_ptr format)
+{
+    auto result = unique_borders.insert(format->get_border_key(), format);
 
-    for (auto key : fonts.order_list) {
-        delete key.first;
-    }
+    format->border_index = (int32_t) unique_borders.index(result.first);
+    format->has_border = result.second;
 }
 
 /*
- * Iterate through the XF Format objects and give them an index to non-default
- * border elements.
+ * Give a format the index of its fill element, adding the fill to the table
+ * of unique fills if it is new.
  */
-void workbook::_prepare_borders()
+void workbook::_prepare_fill(format_ptr format)
 {
-    hash_table<lxw_border_ptr, uint16_t> borders;
-    uint16_t index = 0;
-
-    for (const auto& it : used_xf_formats.order_list) {
-        auto format = it.first;
-        lxw_border_ptr key(format->get_border_key());
-
-        if (key) {
-            /* Look up the format in the hash table. */
-            auto result = borders.exists(key);
-
-            if (result.second) {
-                /* Border has already been used. */
-                format->border_index = result.first.second;
-                format->has_border = false;
-                delete key;
-            }
-            else {
-                /* This is a new border. */
-                uint16_t border_index = index;
-                format->border_index = index;
-                format->has_border = true;
-                borders.insert(key, border_index);
-                index++;
-            }
-        }
+    lxw_fill key = format->get_fill_key();
+
+    /* The following logical statements jointly take care of special */
+    /* cases in relation to cell colors and patterns:                */
+    /* 1. For a solid fill (pattern == 1) Excel reverses the role of */
+    /*    foreground and background colors, and                      */
+    /* 2. If the user specifies a foreground or background color     */
+    /*    without a pattern they probably wanted a solid fill, so    */
+    /*    we fill in the defaults.                                   */
+    if (format->pattern == LXW_PATTERN_SOLID
+        && format->bg_color != LXW_COLOR_UNSET
+        && format->fg_color != LXW_COLOR_UNSET) {
+        lxw_color_t tmp = format->fg_color;
+        format->fg_color = format->bg_color;
+        format->bg_color = tmp;
     }
 
-    for (auto key : borders.order_list) {
-        delete key.first;
+    if (format->pattern <= LXW_PATTERN_SOLID
+        && format->bg_color != LXW_COLOR_UNSET
+        && format->fg_color == LXW_COLOR_UNSET) {
+        format->fg_color = format->bg_color;
+        format->bg_color = LXW_COLOR_UNSET;
+        format->pattern = LXW_PATTERN_SOLID;
     }
 
-    border_count = index;
+    if (format->pattern <= LXW_PATTERN_SOLID
+        && format->bg_color == LXW_COLOR_UNSET
+        && format->fg_color != LXW_COLOR_UNSET) {
+        format->bg_color = LXW_COLOR_UNSET;
+        format->pattern = LXW_PATTERN_SOLID;
+    }
+
+    auto result = unique_fills.insert(key, format);
+
+    format->fill_index = (int32_t) unique_fills.index(result.first);
+    format->has_fill = result.second;
 }
 
 /*
- * Iterate through the XF Format objects and give them an index to non-default
- * fill elements.
+ * Give a format the index of its user defined number format, if it has one.
+ * Note, user defined records start from index 0xA4.
  */
-void workbook::_prepare_fills()
+void workbook::_prepare_num_format(format_ptr format)
 {
+    /* Format already has a number format index. */
+    if (format->num_format_index)
+        return;
 
-    hash_table<lxw_fill_ptr, uint16_t> fills;
+    /* Check if there is a user defined number format string. */
+    if (!*format->num_format)
+        return;
 
-    uint16_t index = 2;
-    lxw_fill_ptr default_fill_1 = new lxw_fill();
-    lxw_fill_ptr default_fill_2 = new lxw_fill();
-    uint16_t fill_index1 = 0;
-    uint16_t fill_index2 = 1;
+    auto result = unique_num_formats.insert(
+        format->num_format, (uint16_t) (0xA4 + unique_num_formats.size()));
 
-    /* Add the default fills. */
-    default_fill_1->pattern = LXW_PATTERN_NONE;
-    default_fill_1->fg_color = LXW_COLOR_UNSET;
-    default_fill_1->bg_color = LXW_COLOR_UNSET;
-    fill_index1 = 0;
-    fills.insert(default_fill_1, fill_index1);
-
-    default_fill_2->pattern = LXW_PATTERN_GRAY_125;
-    default_fill_2->fg_color = LXW_COLOR_UNSET;
-    default_fill_2->bg_color = LXW_COLOR_UNSET;
-    fill_index2 = 1;
-    fills.insert(default_fill_2, fill_index2);
-
-    for (const auto& it : used_xf_formats.order_list) {
-        auto format = it.first;
-        lxw_fill_ptr key(format->get_fill_key());
-
-        /* The following logical statements jointly take care of special */
-        /* cases in relation to cell colors and patterns:                */
-        /* 1. For a solid fill (pattern == 1) Excel reverses the role of */
-        /*    foreground and background colors, and                      */
-        /* 2. If the user specifies a foreground or background color     */
-        /*    without a pattern they probably wanted a solid fill, so    */
-        /*    we fill in the defaults.                                   */
-        if (format->pattern == LXW_PATTERN_SOLID
-            && format->bg_color != LXW_COLOR_UNSET
-            && format->fg_color != LXW_COLOR_UNSET) {
-            lxw_color_t tmp = format->fg_color;
-            format->fg_color = format->bg_color;
-            format->bg_color = tmp;
-        }
+    format->num_format_index = result.first->second;
+}
 
-        if (format->pattern <= LXW_PATTERN_SOLID
-            && format->bg_color != LXW_COLOR_UNSET
-            && format->fg_color == LXW_COLOR_UNSET) {
-            format->fg_color = format->bg_color;
-            format->bg_color = LXW_COLOR_UNSET;
-            format->pattern = LXW_PATTERN_SOLID;
-        }
+/*
+ * Compile the styles of the XF formats in a single pass. Each format is given
+ * an index into the tables of unique fonts, number formats, borders and
+ * fills that are written to styles.xml.
+ */
+void workbook::_prepare_styles()
+{
+    size_t i;
 
-        if (format->pattern <= LXW_PATTERN_SOLID
-            && format->bg_color == LXW_COLOR_UNSET
-            && format->fg_color != LXW_COLOR_UNSET) {
-            format->bg_color = LXW_COLOR_UNSET;
-            format->pattern = LXW_PATTERN_SOLID;
-        }
+    /* Add the default fills. */
+    if (unique_fills.empty()) {
+        lxw_fill default_fill;
 
-        if (key) {
-            /* Look up the format in the hash table. */
-            auto result = fills.exists(key);
+        default_fill.pattern = LXW_PATTERN_NONE;
+        default_fill.fg_color = LXW_COLOR_UNSET;
+        default_fill.bg_color = LXW_COLOR_UNSET;
+        unique_fills.insert(default_fill, NULL);
 
-            if (result.second) {
-                /* Fill has already been used. */
-                format->fill_index = result.first.second;
-                format->has_fill = false;
-                delete key;
-            }
-            else {
-                /* This is a new fill. */
-                uint16_t fill_index = index;
-                format->fill_index = index;
-                format->has_fill = true;
-                fills.insert(key, fill_index);
-                index++;
-            }
-        }
+        default_fill.pattern = LXW_PATTERN_GRAY_125;
+        unique_fills.insert(default_fill, NULL);
     }
 
-    for (auto key : fills.order_list) {
-        delete key.first;
+    /* Formats prepared by a previous save() already have their indices. */
+    for (i = prepared_xf_formats; i < used_xf_formats.size(); i++) {
+        format_ptr format = used_xf_formats[i].second;
+
+        _prepare_font(format);
+        _prepare_num_format(format);
+        _prepare_border(format);
+        _prepare_fill(format);
     }
 
-    fill_count = index;
+    font_count = (uint16_t) unique_fonts.size();
+    border_count = (uint16_t) unique_borders.size();
+    fill_count = (uint16_t) unique_fills.size();
+    num_format_count = (uint16_t) unique_num_formats.size();
 }
 
 /*
- * Iterate through the XF Format objects and give them an index to non-default
- * number format elements. Note, user defined records start from index 0xA4.
+ * Prepare workbook and sub-objects for writing.
  */
-void workbook::_prepare_num_formats()
+void workbook::_prepare_workbook()
 {
-    hash_table<std::string, uint16_t> num_formats;
-    uint16_t index = 0xA4;
-    uint16_t num_format_count = 0;
-    uint16_t num_format_index;
-
-    for (const auto& it : used_xf_formats.order_list) {
-        auto format = it.first;
-        /* Format already has a number format index. */
-        if (format->num_format_index)
-            continue;
+    /* Set the font, number format, border and fill indices for the format
+     * objects. */
+    _prepare_styles();
 
-        /* Check if there is a user defined number format string. */
-        const std::string& num_format = format->num_format;
+    /* Only formats used after this point need to be prepared by save(). */
+    prepared_xf_formats = used_xf_formats.size();
+}
 
-        if (!num_format.empty()) {
-            /* Look up the num_format in the hash table. */
-            auto result = num_formats.exists(num_format);
+/*
+ * Number the shared strings in the order that the worksheet cells use them,
+ * or by how many cells use them, and update the string counts.
+ */
+void workbook::_prepare_shared_strings()
+{
+    if (sst->is_renumbered()) {
+        sst->clear_order();
 
-            if (result.second) {
-                /* Num_Format has already been used. */
-                format->num_format_index = result.first.second;
-            }
-            else {
-                /* This is a new num_format. */
-                num_format_index = index;
-                format->num_format_index = index;
-                num_formats.insert(num_format, num_format_index);
-                index++;
-                num_format_count++;
+        for (const auto& worksheet : worksheets) {
+            for (const auto& row : worksheet->table) {
+                for (const auto& cell : row.second->cells) {
+                    if (cell.second->type == STRING_CELL)
+                        sst->add_to_order(cell.second->u.string_id);
+                }
             }
         }
     }
 
-    this->num_format_count = num_format_count;
-}
-
-/*
- * Prepare workbook and sub-objects for writing.
- */
-void workbook::_prepare_workbook()
-{
-    /* Set the font index for the format objects. */
-    _prepare_fonts();
+    sst->finalize();
 
-    /* Set the number format index for the format objects. */
-    _prepare_num_formats();
+    /* A worksheet kept from the last save() refers to the strings by their
+     * old positions, so it is written again if any of them have moved. */
+    if (!sst->is_renumbered() || !retain_parts)
+        return;
 
-    /* Set the border index for the format objects. */
-    _prepare_borders();
+    for (const auto& worksheet : worksheets) {
+        if (worksheet->dirty || !worksheet->saved_part)
+            continue;
 
-    /* Set the fill index for the format objects. */
-    _prepare_fills();
+        for (const auto& row : worksheet->table) {
+            for (const auto& cell : row.second->cells) {
+                if (cell.second->type == STRING_CELL
+                    && sst->final_index_changed(cell.second->u.string_id)) {
+                    worksheet->dirty = true;
+                    break;
+                }
+            }
 
+            if (worksheet->dirty)
+                break;
+        }
+    }
 }
 
 /*
@@ -382,8 +334,6 @@ lxw_error workbook::_store_defined_name(
  */
 void workbook::_populate_range_data_cache(const series_range_ptr& range)
 {
-    uint16_t num_data_points = 0;
-
     /* If ignore_cache is set then don't try to populate the cache. This flag
      * may be set manually, for testing, or due to a case where the cache
      * can't be calculated.
@@ -391,6 +341,11 @@ void workbook::_populate_range_data_cache(const series_range_ptr& range)
     if (range->ignore_cache)
         return;
 
+    /* Discard the data cached by a previous save(). It may be shared with
+     * other ranges so start a new cache. */
+    range->data_cache = std::make_shared<series_data_cache>();
+    range->has_string_cache = false;
+
     /* Currently we only handle 2D ranges so ensure either the rows or cols
      * are the same.
      */
@@ -416,6 +371,11 @@ void workbook::_populate_range_data_cache(const series_range_ptr& range)
         return;
     }
 
+    series_data_cache& cache = *range->data_cache;
+
+    cache.reserve((range->last_row - range->first_row + 1)
+                  * (range->last_col - range->first_col + 1));
+
     /* Iterate through the worksheet data and populate the range cache. */
     for (lxw_row_t row_num = range->first_row; row_num <= range->last_row; row_num++) {
         lxw_row *row_obj = worksheet->find_row(row_num);
@@ -423,36 +383,31 @@ void workbook::_populate_range_data_cache(const series_range_ptr& range)
         for (lxw_col_t col_num = range->first_col; col_num <= range->last_col;
              col_num++) {
 
-            std::shared_ptr<series_data_point> data_point = std::make_shared<series_data_point>();
-            if (!data_point) {
-                range->ignore_cache = true;
-                return;
-            }
-
             lxw_cell *cell_obj = worksheet->find_cell(row_obj, col_num);
 
-            if (cell_obj) {
-                if (cell_obj->type == NUMBER_CELL) {
-                    data_point->number = cell_obj->u.number;
-                }
-
-                if (cell_obj->type == STRING_CELL) {
-                    data_point->string = cell_obj->sst_string;
-                    data_point->is_string = true;
-                    range->has_string_cache = true;
-                }
+            if (!cell_obj) {
+                /* The blank cells of merged ranges aren't stored. */
+                if (worksheet->_in_merged_blank_range(row_num, col_num))
+                    cache.add_number(0);
+                else
+                    cache.add_missing();
+            }
+            else if (cell_obj->type == NUMBER_CELL) {
+                cache.add_number(cell_obj->u.number);
+            }
+            else if (cell_obj->type == STRING_CELL) {
+                cache.add_string(sst->get_string(cell_obj->u.string_id));
+                range->has_string_cache = true;
+            }
+            else if (cell_obj->type == INLINE_STRING_CELL) {
+                cache.add_string(*cell_obj->u.string);
+                range->has_string_cache = true;
             }
             else {
-                data_point->no_data = true;
+                cache.add_number(0);
             }
-
-            range->data_cache.push_back(data_point);
-            num_data_points++;
         }
     }
-
-    range->num_data_points = num_data_points;
-
 }
 
 /* Convert a chart range such as Sheet1!$A$1:$A$5 to a sheet name and row-col
@@ -535,12 +490,43 @@ void workbook::_populate_range_dimensions(const series_range_ptr& range)
     }
 }
 
-/* Set the range dimensions and set the data cache.
+/* Set the range dimensions and set the data cache. Ranges with the same
+ * formula are only resolved once per save, and share the same cached data.
  */
 void workbook::_populate_range(const series_range_ptr& range)
 {
+    /* Ranges with data added manually, or for testing, are left as they
+     * are. */
+    if (range->user_data)
+        return;
+
+    /* Ranges that couldn't be read by a previous save(), such as ranges on
+     * a worksheet that hadn't been added yet, are tried again. */
+    range->ignore_cache = false;
+
+    if (!range->formula.empty()) {
+        auto *resolved = resolved_ranges.find(range->formula);
+
+        if (resolved) {
+            const series_range_ptr& source = resolved->second;
+
+            range->sheetname = source->sheetname;
+            range->first_row = source->first_row;
+            range->last_row = source->last_row;
+            range->first_col = source->first_col;
+            range->last_col = source->last_col;
+            range->ignore_cache = source->ignore_cache;
+            range->has_string_cache = source->has_string_cache;
+            range->data_cache = source->data_cache;
+            return;
+        }
+    }
+
     _populate_range_dimensions(range);
     _populate_range_data_cache(range);
+
+    if (!range->formula.empty())
+        resolved_ranges.insert(range->formula, range);
 }
 
 /*
@@ -551,6 +537,8 @@ void workbook::_add_chart_cache_data()
 {
     std::vector<chart*> charts;
 
+    resolved_ranges.clear();
+
     for (const auto& chart : ordered_charts) {
         charts.push_back(chart);
         if (chart->combined)
@@ -572,6 +560,66 @@ void workbook::_add_chart_cache_data()
             _populate_range(series->title.range);
         }
     }
+
+    resolved_ranges.clear();
+}
+
+/*
+ * Check if two images with the same hash and size have the same data. Images
+ * whose files can't be read are treated as different, so that the error is
+ * reported when the package is assembled.
+ */
+static bool _same_image_data(const image_options_ptr& image1,
+                             const image_options_ptr& image2)
+{
+    unsigned char buffer1[LXW_BUFFER_SIZE];
+    unsigned char buffer2[LXW_BUFFER_SIZE];
+    FILE *stream1 = NULL;
+    FILE *stream2 = NULL;
+    bool same = true;
+    size_t offset;
+    size_t size;
+
+    if (image1->data_size != image2->data_size)
+        return false;
+
+    if (!image1->image_buffer.empty() && !image2->image_buffer.empty())
+        return image1->image_buffer == image2->image_buffer;
+
+    if (image1->image_buffer.empty() && image2->image_buffer.empty()
+        && image1->filename == image2->filename)
+        return true;
+
+    if (image1->image_buffer.empty()) {
+        stream1 = fopen(image1->filename.c_str(), "rb");
+        if (!stream1)
+            same = false;
+    }
+
+    if (same && image2->image_buffer.empty()) {
+        stream2 = fopen(image2->filename.c_str(), "rb");
+        if (!stream2)
+            same = false;
+    }
+
+    for (offset = 0; same && offset < image1->data_size; offset += size) {
+        size = image1->data_size - offset;
+        if (size > LXW_BUFFER_SIZE)
+            size = LXW_BUFFER_SIZE;
+
+        if (image1->read_data(stream1, offset, buffer1, size) != size
+            || image2->read_data(stream2, offset, buffer2, size) != size
+            || memcmp(buffer1, buffer2, size) != 0)
+            same = false;
+    }
+
+    if (stream1)
+        fclose(stream1);
+
+    if (stream2)
+        fclose(stream2);
+
+    return same;
 }
 
 /*
@@ -581,10 +629,25 @@ void workbook::_prepare_drawings()
 {
     uint16_t chart_ref_id = 0;
     uint16_t image_ref_id = 0;
+    std::map<std::tuple<uint64_t, size_t, uint8_t>,
+             std::vector<std::pair<image_options_ptr, uint16_t> > > media_ids;
     uint16_t drawing_id = 0;
 
+    /* Start again from the worksheet data on each save(). */
+    ordered_charts.clear();
+    ordered_images.clear();
+    has_png = false;
+    has_jpeg = false;
+    has_bmp = false;
+
     for (const auto& worksheet : worksheets) {
 
+        worksheet->drawing.reset();
+        worksheet->drawing_links.clear();
+        worksheet->drawing_rel_ids.clear();
+        worksheet->size_index_valid = false;
+        worksheet->external_drawing_links.clear();
+
         if (worksheet->image_data.empty() && worksheet->chart_data.empty())
             continue;
 
@@ -608,9 +671,37 @@ void workbook::_prepare_drawings()
             if (image_options->image_type == LXW_IMAGE_BMP)
                 has_bmp = true;
 
-            image_ref_id++;
+            /* Identical images are stored once in the package. The data of
+             * images with the same hash is compared in case they collide. */
+            auto key = std::make_tuple(image_options->data_hash,
+                                       image_options->data_size,
+                                       image_options->image_type);
+            auto& media = media_ids[key];
+            uint16_t media_id = 0;
+
+            for (const auto& stored : media) {
+                auto same = image_options->same_data.find(stored.first.get());
+
+                /* The data is only read again for a new pair of images. */
+                if (same == image_options->same_data.end())
+                    same = image_options->same_data.insert(std::make_pair(
+                               stored.first.get(),
+                               _same_image_data(stored.first,
+                                                image_options))).first;
+
+                if (same->second) {
+                    media_id = stored.second;
+                    break;
+                }
+            }
 
-            worksheet->prepare_image(image_ref_id, drawing_id, image_options);
+            if (!media_id) {
+                ordered_images.push_back(image_options);
+                media_id = ++image_ref_id;
+                media.push_back(std::make_pair(image_options, media_id));
+            }
+
+            worksheet->prepare_image(media_id, drawing_id, image_options);
         }
     }
 
@@ -629,6 +720,15 @@ void workbook::_prepare_defined_names()
     std::string first_col;// 8
     std::string last_col; // 8
 
+    /* Replace the names stored by a previous save() so that they follow any
+     * changes to the worksheet settings. */
+    for (const auto& name : sheet_defined_names)
+        defined_names.erase(name);
+
+    sheet_defined_names.clear();
+
+    std::set<defined_name_ptr, sort_defined_names> user_names(defined_names);
+
     for (const auto& worksheet : worksheets) {
 
         /*
@@ -762,6 +862,11 @@ void workbook::_prepare_defined_names()
             }
         }
     }
+
+    for (const auto& name : defined_names) {
+        if (!user_names.count(name))
+            sheet_defined_names.push_back(name);
+    }
 }
 
 /*****************************************************************************
@@ -830,10 +935,10 @@ void workbook::_write_workbook_view()
     };
 
     if (first_sheet)
-        attributes.push_back({"firstSheet", std::to_string(first_sheet)});
+        attributes.push_back({"firstSheet", std::to_string(first_sheet.load())});
 
     if (active_sheet)
-        attributes.push_back({"activeTab", std::to_string(active_sheet)});
+        attributes.push_back({"activeTab", std::to_string(active_sheet.load())});
 
     lxw_xml_empty_tag("workbookView", attributes);
 }
@@ -987,7 +1092,8 @@ void workbook::assemble_xml_file()
  * Create a new workbook object.
  */
 
-workbook::workbook(const std::string& file, const workbook_options& options) : filename(file)
+workbook::workbook(const std::string& file, const workbook_options& options)
+    : filename(file)
 {
     num_xf_formats = 0;
     first_sheet = 0;
@@ -1000,6 +1106,8 @@ workbook::workbook(const std::string& file, const workbook_options& options) : f
     border_count = 0;
     fill_count = 0;
     optimize = false;
+    prepared_xf_formats = 0;
+    retain_parts = false;
     workbook_new_opt(options);
 }
 
@@ -1007,11 +1115,12 @@ workbook::~workbook()
 {
     worksheet_names.clear();
 
-    for(auto p : used_xf_formats.order_list)
-    {
+    /* The workbook owns all the formats, whether or not they were used. */
+    for (const auto& p : used_xf_formats)
         delete p.first;
-        delete p.second;
-    }
+
+    for (const auto& format : formats)
+        delete format;
 }
 
 /*
@@ -1019,8 +1128,13 @@ workbook::~workbook()
  */
 void workbook::workbook_new_opt(const workbook_options& options)
 {
-    /* Add the shared strings table. */
-    sst = std::make_shared<xlsxwriter::sst>();
+    /* Add the shared strings table. The strings of a constant_memory
+     * workbook are written as they are added so they can't be renumbered. */
+    sst = std::make_shared<xlsxwriter::sst>(
+              options.concurrent_strings && !options.constant_memory,
+              options.order_strings_by_frequency && !options.constant_memory,
+              options.disk_shared_strings, options.tmpdir,
+              options.spool_threshold);
 
     /* Add the default cell format. */
     auto format = add_format();
@@ -1030,6 +1144,12 @@ void workbook::workbook_new_opt(const workbook_options& options)
 
     this->options.constant_memory = options.constant_memory;
     this->options.tmpdir = options.tmpdir;
+    this->options.spool_threshold = options.spool_threshold;
+    this->options.use_part_cache = options.use_part_cache;
+    this->options.concurrent_strings = options.concurrent_strings;
+    this->options.order_strings_by_frequency = options.order_strings_by_frequency;
+    this->options.disk_shared_strings = options.disk_shared_strings;
+    this->options.package_threads = options.package_threads;
 
     first_sheet = 0;
     active_sheet = 0;
@@ -1079,6 +1199,7 @@ worksheet* workbook::add_worksheet(const std::string& sheetname)
     init_data.active_sheet = &active_sheet;
     init_data.first_sheet = &first_sheet;
     init_data.tmpdir = options.tmpdir;
+    init_data.spool_threshold = options.spool_threshold;
 
     /* Create a new worksheet object. */
     worksheet_ptr worksheet = std::make_shared<xlsxwriter::worksheet>(&init_data);
@@ -1138,6 +1259,8 @@ chart* workbook::add_chart(uint8_t type)
     default:
         return nullptr;
     }
+    std::lock_guard<std::mutex> lock(mutex);
+
     charts.push_back(chart);
     return chart.get();
 }
@@ -1146,22 +1269,98 @@ chart* workbook::add_chart(uint8_t type)
  * Add a new format to the Excel workbook.
  */
 format* workbook::add_format()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    return _add_format();
+}
+
+/*
+ * Add a new format to the workbook with the lock held.
+ */
+format* workbook::_add_format()
 {
     /* Create a new format object. */
     format_ptr format = new xlsxwriter::format();
 
     format->xf_format_indices = &used_xf_formats;
     format->num_xf_formats = &num_xf_formats;
+    format->xf_format_mutex = &mutex;
 
     formats.push_back(format);
 
     return format;
 }
 
+/*
+ * Add a string to the shared string table and return a handle to it.
+ */
+sst_handle workbook::intern_string(const std::string& string)
+{
+    if (string.empty() || string.size() > LXW_STR_MAX)
+        return sst_handle();
+
+    /* Leave the string out of the file if it isn't written to a cell. The
+     * strings of a constant_memory workbook are numbered as they are added
+     * so they are all written. */
+    if (!options.constant_memory)
+        sst->drop_unused_strings();
+
+    return sst_handle(sst->intern(string));
+}
+
+/*
+ * Get the shared workbook format for a format spec.
+ */
+format* workbook::intern_format(const format_spec& spec)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto result = interned_formats.find(spec);
+
+    if (result)
+        return result->second;
+
+    format_ptr format = _add_format();
+
+    memcpy((void *) format, (const void *) &spec.properties,
+           sizeof(xlsxwriter::format));
+    format->xf_format_indices = &used_xf_formats;
+    format->num_xf_formats = &num_xf_formats;
+    format->xf_format_mutex = &mutex;
+
+    interned_formats.insert(spec, format);
+
+    return format;
+}
+
 /*
  * Call finalization code and close file.
  */
 lxw_error workbook::close()
+{
+    return _save(filename);
+}
+
+/*
+ * Write the file and keep the workbook open for further changes.
+ */
+lxw_error workbook::save(const std::string& path)
+{
+    if (options.constant_memory)
+        return LXW_ERROR_SAVE_CONSTANT_MEMORY;
+
+    retain_parts = true;
+
+    return _save(path);
+}
+
+/*
+ * Assemble the xlsx file for close() or save().
+ */
+lxw_error workbook::_save(const std::string& path,
+                          const std::atomic<bool> *cancelled,
+                          const std::function<void(uint32_t, uint32_t)>& progress)
 {
     lxw_error error = LXW_NO_ERROR;
 
@@ -1169,17 +1368,39 @@ lxw_error workbook::close()
     if (worksheets.empty())
         add_worksheet();
 
+    /* Move the cells written to worksheet bands into the worksheets. */
+    for (const auto& sheet : worksheets)
+        sheet->_merge_bands();
+
     /* Ensure that at least one worksheet has been selected. */
     if (active_sheet == 0) {
         const auto& sheet = worksheets.front();
+
+        if (!sheet->selected)
+            sheet->default_selected = true;
+
+        if (!sheet->selected || sheet->hidden)
+            sheet->dirty = true;
+
         sheet->selected = 1;
         sheet->hidden = 0;
     }
 
-    /* Set the active sheet. */
+    /* Set the active sheet. The worksheets that were active, or selected
+     * by default, in a previous save() are reset. */
     for (const auto& sheet : worksheets) {
-        if (sheet->index == active_sheet)
-            sheet->active = 1;
+        uint8_t active = sheet->index == active_sheet;
+
+        if (sheet->active != active) {
+            sheet->active = active;
+            sheet->dirty = true;
+        }
+
+        if (active_sheet != 0 && sheet->default_selected) {
+            sheet->selected = false;
+            sheet->default_selected = false;
+            sheet->dirty = true;
+        }
     }
 
     /* Set the defined names for the worksheets such as Print Titles. */
@@ -1191,11 +1412,23 @@ lxw_error workbook::close()
     /* Add cached data to charts. */
     _add_chart_cache_data();
 
+    /* Number the strings used by the worksheet cells. */
+    _prepare_shared_strings();
+
     /* Create a packager object to assemble sub-elements into a zip file. */
-    std::shared_ptr<packager> pkger = std::make_shared<packager>(filename, options.tmpdir);
+    std::shared_ptr<packager> pkger = std::make_shared<packager>(path, options.tmpdir,
+                                                               options.spool_threshold);
 
     /* Set the workbook object in the packager. */
     pkger->workbook = this;
+    pkger->cancelled = cancelled;
+    pkger->progress = progress;
+    pkger->threads = options.package_threads;
+
+    if (options.use_part_cache)
+        pkger->cache = &part_cache::global();
+    else if (retain_parts)
+        pkger->cache = &saved_parts;
 
     /* Assemble all the sub-files in the xlsx package. */
     error = (lxw_error)pkger->create_package();
@@ -1203,31 +1436,76 @@ lxw_error workbook::close()
     /* Error and non-error conditions fall through to the cleanup code. */
     if (error == LXW_ERROR_CREATING_TMPFILE) {
         std::cerr << "[ERROR] workbook_close(): "
-             << "Error creating tmpfile(s) to assemble '" << filename << "'. "
+             << "Error creating tmpfile(s) to assemble '" << path << "'. "
              << "Error = " << strerror(errno) << std::endl;
     }
 
     /* If LXW_ERROR_ZIP_FILE_OPERATION then errno is set by zlib. */
     if (error == LXW_ERROR_ZIP_FILE_OPERATION) {
         std::cerr << "[ERROR] workbook_close(): "
-             << "Zlib error while creating xlsx file '" << filename << "'. "
+             << "Zlib error while creating xlsx file '" << path << "'. "
              << "Error = " << strerror(errno) << std::endl;
     }
 
     /* The next 2 error conditions don't set errno. */
     if (error == LXW_ERROR_ZIP_FILE_ADD) {
         std::cerr << "[ERROR] workbook_close(): "
-            << "Zlib error adding file to xlsx file '"<< filename <<"'." << std::endl;
+            << "Zlib error adding file to xlsx file '"<< path <<"'." << std::endl;
     }
 
     if (error == LXW_ERROR_ZIP_CLOSE) {
         std::cerr << "[ERROR] workbook_close(): "
-                  << "Zlib error closing xlsx file ' " << filename <<"'." << std::endl;
+                  << "Zlib error closing xlsx file ' " << path <<"'." << std::endl;
     }
 
     return error;
 }
 
+/*
+ * Run the close on an executor or a library owned thread and return the
+ * result as a future.
+ */
+std::future<lxw_error> workbook::close_async(const close_options& options)
+{
+    /* Keep the workbook alive until the close has finished. */
+    workbook_ptr self = shared_from_this();
+    std::shared_ptr<std::atomic<bool>> cancelled =
+        std::make_shared<std::atomic<bool>>(false);
+    std::function<void(uint32_t, uint32_t)> progress = options.progress;
+
+    std::shared_ptr<std::packaged_task<lxw_error()>> task =
+        std::make_shared<std::packaged_task<lxw_error()>>(
+            [self, cancelled, progress]() -> lxw_error {
+                if (*cancelled)
+                    return LXW_ERROR_CLOSE_CANCELLED;
+                return self->_save(self->filename, cancelled.get(), progress);
+            });
+
+    std::future<lxw_error> result = task->get_future();
+
+    /* A cancel_close() only applies to this close from now on. */
+    std::atomic_store(&close_cancelled, cancelled);
+
+    if (options.executor)
+        options.executor([task]() { (*task)(); });
+    else
+        std::thread([task]() { (*task)(); }).detach();
+
+    return result;
+}
+
+/*
+ * Request that a pending close_async() stops at the next package file.
+ */
+void workbook::cancel_close()
+{
+    std::shared_ptr<std::atomic<bool>> cancelled =
+        std::atomic_load(&close_cancelled);
+
+    if (cancelled)
+        *cancelled = true;
+}
+
 /*
  * Create a defined name in Excel. We handle global/workbook level names and
  * local/worksheet names.
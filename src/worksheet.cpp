@@ -8,19 +8,19 @@
  */
 
 #include <ctype.h>
+#include <math.h>
 
 #include <xlsxwriter/xmlwriter.hpp>
 #include <xlsxwriter/worksheet.hpp>
 #include <xlsxwriter/format.hpp>
 #include <xlsxwriter/utility.hpp>
 #include <xlsxwriter/relationships.hpp>
+#include <xlsxwriter/hash_table.hpp>
 #include <iostream>
 #include <sstream>
 #include <algorithm>
 #include <iomanip>
 
-#define LXW_STR_MAX      32767
-#define LXW_BUFFER_SIZE  4096
 #define LXW_PORTRAIT     1
 #define LXW_LANDSCAPE    0
 #define LXW_PRINT_ACROSS 1
@@ -81,20 +81,15 @@ worksheet::worksheet(lxw_worksheet_init_data *init_data)
     default_row_zeroed = 0;
 
     if (init_data && init_data->optimize) {
-        FILE *tmpfile;
+        optimize_tmpfile.reset(new spool(init_data->tmpdir,
+                                         init_data->spool_threshold));
 
-        if (init_data)
-            tmpfile = lxw_tmpfile(init_data->tmpdir.c_str());
-        else
-            tmpfile = lxw_tmpfile(NULL);
-
-        if (!tmpfile) {
+        if (optimize_tmpfile->error()) {
             throw std::string("Error creating tmpfile() for worksheet in "
                       "'constant_memory' mode.");
         }
 
-        optimize_tmpfile = tmpfile;
-        file = optimize_tmpfile;
+        file = optimize_tmpfile.get();
     }
 
     /* Initialize the worksheet dimensions. */
@@ -130,6 +125,7 @@ worksheet::worksheet(lxw_worksheet_init_data *init_data)
     print_gridlines = 0;
     screen_gridlines = 1;
     selected = false;
+    default_selected = false;
     print_options_changed = 0;
     zoom = 100;
     zoom_scale_normal = true;
@@ -142,6 +138,9 @@ worksheet::worksheet(lxw_worksheet_init_data *init_data)
 
     row_size_changed = false;
     col_size_changed = false;
+    size_index_valid = false;
+
+    string_storage = LXW_STRING_STORAGE_SHARED;
 
     header_footer_changed = false;
 
@@ -150,6 +149,7 @@ worksheet::worksheet(lxw_worksheet_init_data *init_data)
     vbreaks_count = 0;
     hlink_count = 0;
     rel_count = 0;
+    dirty = true;
 
     if (init_data) {
         name = init_data->name;
@@ -208,7 +208,7 @@ lxw_cell * _new_number_cell(lxw_row_t row_num, lxw_col_t col_num, double value,
  * Create a new worksheet string cell object.
  */
 lxw_cell * _new_string_cell(lxw_row_t row_num,
-                 lxw_col_t col_num, int32_t string_id, std::string *sst_string,
+                 lxw_col_t col_num, int32_t string_id,
                  xlsxwriter::format *format)
 {
     lxw_cell *cell = new lxw_cell();
@@ -218,7 +218,6 @@ lxw_cell * _new_string_cell(lxw_row_t row_num,
     cell->type = STRING_CELL;
     cell->format = format;
     cell->u.string_id = string_id;
-    cell->sst_string = sst_string;
 
     return cell;
 }
@@ -417,6 +416,8 @@ void worksheet::_insert_cell(lxw_row_t row_num, lxw_col_t col_num, lxw_cell *cel
 {
     lxw_row *row = _get_row(row_num);
 
+    dirty = true;
+
     if (!optimize) {
         row->data_changed = true;
         _insert_cell_list(row->cells, cell, col_num);
@@ -441,9 +442,120 @@ void worksheet::_insert_hyperlink(lxw_row_t row_num, lxw_col_t col_num, lxw_cell
 {
     lxw_row *row = _get_row_list(hyperlinks, row_num);
 
+    dirty = true;
+
     _insert_cell_list(row->cells, link, col_num);
 }
 
+/*
+ * Move the rows written to the worksheet bands into the worksheet, in row
+ * order, and add their strings to the shared string table.
+ */
+void worksheet::_merge_bands()
+{
+    for (const auto& band : bands) {
+        if (band->table.empty())
+            continue;
+
+        for (const auto& band_row : band->table) {
+            lxw_row *row = band_row.second;
+
+            for (const auto& pair : row->cells) {
+                lxw_cell *cell = pair.second;
+
+                if (cell->type != STRING_CELL)
+                    continue;
+
+                const std::string& string = band->strings[cell->u.string_id];
+
+                if (_use_inline_string(pair.first, string)) {
+                    cell->type = INLINE_STRING_CELL;
+                    cell->u.string = _copy_inline_string(string);
+                }
+                else {
+                    cell->u.string_id = sst->get_sst_index(string);
+                }
+            }
+
+            auto it = table.insert(std::make_pair(band_row.first, row));
+
+            /* Move the cells into a row that already exists. */
+            if (!it.second) {
+                lxw_row *existing_row = it.first->second;
+
+                for (const auto& pair : row->cells)
+                    _insert_cell_list(existing_row->cells, pair.second, pair.first);
+
+                existing_row->data_changed = true;
+                row->cells.clear();
+                delete row;
+            }
+        }
+
+        if (band->dim_rowmin < dim_rowmin)
+            dim_rowmin = band->dim_rowmin;
+        if (band->dim_rowmax > dim_rowmax)
+            dim_rowmax = band->dim_rowmax;
+        if (band->dim_colmin < dim_colmin)
+            dim_colmin = band->dim_colmin;
+        if (band->dim_colmax > dim_colmax)
+            dim_colmax = band->dim_colmax;
+
+        band->table.clear();
+        band->table.cached_row = nullptr;
+        band->table.cached_row_num = LXW_ROW_MAX + 1;
+        band->strings.clear();
+
+        dirty = true;
+    }
+}
+
+/*
+ * Check if a string written to a column should be stored inline instead of in
+ * the shared string table.
+ */
+bool worksheet::_use_inline_string(lxw_col_t col_num, const std::string& string)
+{
+    uint8_t storage = string_storage;
+
+    if (col_num < col_string_storage.size() && col_string_storage[col_num])
+        storage = col_string_storage[col_num];
+
+    if (storage != LXW_STRING_STORAGE_ADAPTIVE)
+        return storage == LXW_STRING_STORAGE_INLINE;
+
+    if (col_num >= string_sketches.size())
+        string_sketches.resize(col_num + 1);
+
+    std::unique_ptr<lxw_string_sketch>& sketch = string_sketches[col_num];
+
+    if (!sketch)
+        sketch.reset(new lxw_string_sketch());
+
+    sketch->add(lxw_hash_bytes(string.data(), string.size()));
+
+    /* Store the strings inline while more than 3/4 of them are different,
+     * since sharing them saves little and only grows the table. */
+    if (sketch->count % LXW_SKETCH_INTERVAL == 0)
+        sketch->use_inline = sketch->estimate() * 4 > sketch->count * 3.0;
+
+    return sketch->use_inline;
+}
+
+/*
+ * Copy a string for an inline string cell, escaping any control characters.
+ */
+std::string *worksheet::_copy_inline_string(const std::string& string)
+{
+    if (strpbrk(string.c_str(), "\x01\x02\x03\x04\x05\x06\x07\x08\x0B\x0C"
+                "\x0D\x0E\x0F\x10\x11\x12\x13\x14\x15\x16"
+                "\x17\x18\x19\x1A\x1B\x1C\x1D\x1E\x1F")) {
+        return new std::string(lxw_escape_control_characters(string));
+    }
+
+    return new std::string(string);
+}
+
 /*
  * Check that row and col are within the allowed Excel range and store max
  * and min values for use in other methods/elements.
@@ -1061,17 +1173,16 @@ void worksheet::_write_optimized_sheet_data()
 
         lxw_xml_start_tag("sheetData");
 
-        /* Flush and rewind the temp file. */
-        fflush(optimize_tmpfile);
-        rewind(optimize_tmpfile);
+        /* Rewind the spooled row data and copy it to the sheet file. */
+        optimize_tmpfile->rewind();
 
         while (read_size) {
             read_size =
-                fread(buffer, 1, LXW_BUFFER_SIZE, optimize_tmpfile);
-            fwrite(buffer, 1, read_size, file);
+                optimize_tmpfile->read(buffer, LXW_BUFFER_SIZE);
+            file->write(buffer, read_size);
         }
 
-        fclose(optimize_tmpfile);
+        optimize_tmpfile.reset();
 
         lxw_xml_end_tag("sheetData");
     }
@@ -1250,6 +1361,33 @@ void worksheet::_write_row(lxw_row *row, const std::string& spans)
 
 }
 
+/*
+ * Convert a column width in user's units to pixels.
+ */
+static uint32_t _col_width_pixels(double width)
+{
+    double max_digit_width = 7.0;       /* For Calabri 11. */
+    double padding = 5.0;
+
+    if (width == 0)
+        return 0;
+    else if (width < 1.0)
+        return (uint32_t) (width * (max_digit_width + padding) + 0.5);
+    else
+        return (uint32_t) (width * max_digit_width + 0.5) + 5;
+}
+
+/*
+ * Convert a row height in points to pixels.
+ */
+static uint32_t _row_height_pixels(double height)
+{
+    if (height == 0)
+        return 0;
+    else
+        return (uint32_t) (4.0 / 3.0 * height);
+}
+
 /*
  * Convert the width of a cell from user's units to pixels. Excel rounds the
  * column width to the nearest pixel. If the width hasn't been set by the user
@@ -1259,9 +1397,6 @@ int32_t worksheet::_size_col(lxw_col_t col_num)
 {
     lxw_col_options *col_opt = nullptr;
     uint32_t pixels;
-    double width;
-    double max_digit_width = 7.0;       /* For Calabri 11. */
-    double padding = 5.0;
     lxw_col_t col_index;
 
     /* Search for the col number in the array of col_options. Each col_option
@@ -1278,23 +1413,10 @@ int32_t worksheet::_size_col(lxw_col_t col_num)
         }
     }
 
-    if (col_opt) {
-        width = col_opt->width;
-
-        /* Convert to pixels. */
-        if (width == 0) {
-            pixels = 0;
-        }
-        else if (width < 1.0) {
-            pixels = (uint32_t) (width * (max_digit_width + padding) + 0.5);
-        }
-        else {
-            pixels = (uint32_t) (width * max_digit_width + 0.5) + 5;
-        }
-    }
-    else {
+    if (col_opt)
+        pixels = _col_width_pixels(col_opt->width);
+    else
         pixels = default_col_pixels;
-    }
 
     return pixels;
 }
@@ -1308,23 +1430,93 @@ int32_t worksheet::_size_row(lxw_row_t row_num)
 {
     lxw_row *row;
     uint32_t pixels;
-    double height;
 
     row = find_row(row_num);
 
-    if (row) {
-        height = row->height;
+    if (row)
+        pixels = _row_height_pixels(row->height);
+    else
+        pixels = (uint32_t) (4.0 / 3.0 * default_row_height);
 
-        if (height == 0)
-            pixels = 0;
-        else
-            pixels = (uint32_t) (4.0 / 3.0 * height);
+    return pixels;
+}
+
+/*
+ * Build the prefix sums of the column widths and row heights, so that the
+ * absolute position of each object is found without summing the size of
+ * every row and column before it.
+ */
+void worksheet::_index_sizes()
+{
+    std::vector<uint32_t> widths;
+    uint32_t default_row = (uint32_t) (4.0 / 3.0 * default_row_height);
+    int64_t sum = 0;
+    size_t i;
+
+    /* Columns are stored densely up to the last one with options. The
+     * options are applied in reverse so the first match wins, as in
+     * _size_col(). */
+    for (i = col_options.size(); i > 0; i--) {
+        const lxw_col_options *col_opt = col_options[i - 1].get();
+
+        if (!col_opt)
+            continue;
+
+        if (col_opt->lastcol >= widths.size())
+            widths.resize(col_opt->lastcol + 1, default_col_pixels);
+
+        std::fill(widths.begin() + col_opt->firstcol,
+                  widths.begin() + col_opt->lastcol + 1,
+                  _col_width_pixels(col_opt->width));
     }
-    else {
-        pixels = (uint32_t) (4.0 / 3.0 * default_row_height);
+
+    col_size_sums.assign(1, 0);
+
+    for (i = 0; i < widths.size(); i++)
+        col_size_sums.push_back(col_size_sums.back() + widths[i]);
+
+    /* Rows are stored sparsely, as differences from the default height. */
+    row_size_rows.clear();
+    row_size_sums.assign(1, 0);
+
+    for (const auto& it : table) {
+        int64_t delta = (int64_t) _row_height_pixels(it.second->height)
+                        - default_row;
+
+        if (!delta)
+            continue;
+
+        sum += delta;
+        row_size_rows.push_back(it.first);
+        row_size_sums.push_back(sum);
     }
 
-    return pixels;
+    size_index_valid = true;
+}
+
+/*
+ * Get the sum of the widths of the columns before a column, in pixels.
+ */
+uint32_t worksheet::_col_offset(lxw_col_t col_num)
+{
+    size_t last = col_size_sums.size() - 1;
+
+    if (col_num <= last)
+        return col_size_sums[col_num];
+
+    return col_size_sums[last] + default_col_pixels * (uint32_t) (col_num - last);
+}
+
+/*
+ * Get the sum of the heights of the rows before a row, in pixels.
+ */
+uint32_t worksheet::_row_offset(lxw_row_t row_num)
+{
+    uint32_t default_row = (uint32_t) (4.0 / 3.0 * default_row_height);
+    size_t count = std::lower_bound(row_size_rows.begin(), row_size_rows.end(),
+                                    row_num) - row_size_rows.begin();
+
+    return (uint32_t) ((int64_t) default_row * row_num + row_size_sums[count]);
 }
 
 /*
@@ -1363,6 +1555,7 @@ int32_t worksheet::_size_row(lxw_row_t row_num)
  * underlying cells.
  */
 void worksheet::_position_object_pixels(const image_options_ptr& image,
+                                  double width, double height,
                                   const drawing_object_ptr& drawing_object)
 {
     lxw_col_t col_start;        /* Column containing upper left corner.  */
@@ -1377,20 +1570,13 @@ void worksheet::_position_object_pixels(const image_options_ptr& image,
     lxw_row_t row_end;          /* Row containing bottom right corner.   */
     double y2;                  /* Distance to bottom of object.         */
 
-    double width;               /* Width of object frame.                */
-    double height;              /* Height of object frame.               */
-
     uint32_t x_abs = 0;         /* Abs. distance to left side of object. */
     uint32_t y_abs = 0;         /* Abs. distance to top  side of object. */
 
-    uint32_t i;
-
     col_start = image->col;
     row_start = image->row;
     x1 = image->x_offset;
     y1 = image->y_offset;
-    width = image->width;
-    height = image->height;
 
     /* Adjust start column for negative offsets. */
     while (x1 < 0 && col_start > 0) {
@@ -1411,10 +1597,12 @@ void worksheet::_position_object_pixels(const image_options_ptr& image,
     if (y1 < 0)
         y1 = 0;
 
+    if ((col_size_changed || row_size_changed) && !size_index_valid)
+        _index_sizes();
+
     /* Calculate the absolute x offset of the top-left vertex. */
     if (col_size_changed) {
-        for (i = 0; i < col_start; i++)
-            x_abs += _size_col(i);
+        x_abs += _col_offset(col_start);
     }
     else {
         /* Optimization for when the column widths haven't changed. */
@@ -1426,8 +1614,7 @@ void worksheet::_position_object_pixels(const image_options_ptr& image,
     /* Calculate the absolute y offset of the top-left vertex. */
     /* Store the column change to allow optimizations. */
     if (row_size_changed) {
-        for (i = 0; i < row_start; i++)
-            y_abs += _size_row(i);
+        y_abs += _row_offset(row_start);
     }
     else {
         /* Optimization for when the row heights haven"t changed. */
@@ -1492,10 +1679,11 @@ void worksheet::_position_object_pixels(const image_options_ptr& image,
  * Therefore, 12,700 * 3 /4 = 9,525 EMUs per pixel.
  */
 void worksheet::_position_object_emus( const image_options_ptr& image,
+                                 double width, double height,
                                  const drawing_object_ptr& drawing_object)
 {
 
-    _position_object_pixels(image, drawing_object);
+    _position_object_pixels(image, width, height, drawing_object);
 
     /* Convert the pixel values to EMUs. See above. */
     drawing_object->from.col_offset *= 9525;
@@ -1550,11 +1738,7 @@ void worksheet::prepare_image(uint16_t image_ref_id, uint16_t drawing_id,
     width *= 96.0 / image_data->x_dpi;
     height *= 96.0 / image_data->y_dpi;
 
-    /* Convert to the nearest pixel. */
-    image_data->width = width;
-    image_data->height = height;
-
-    _position_object_emus(image_data, drawing_object);
+    _position_object_emus(image_data, width, height, drawing_object);
 
     /* Convert from pixels to emus. */
     drawing_object->width = (uint32_t) (0.5 + width * 9525);
@@ -1562,16 +1746,25 @@ void worksheet::prepare_image(uint16_t image_ref_id, uint16_t drawing_id,
 
     drawing->add_drawing_object(drawing_object);
 
-    relationship = std::make_shared<xlsxwriter::rel_tuple>();
-
-    relationship->type = "/image";
-
     lxw_snprintf(filename, 32, "../media/image%d.%s", image_ref_id,
                  image_data->extension.c_str());
 
+    /* Reuse the relationship if the image is already in the drawing. */
+    auto rel_id = drawing_rel_ids.find(filename);
+    if (rel_id != drawing_rel_ids.end()) {
+        drawing_object->rel_index = rel_id->second;
+        return;
+    }
+
+    relationship = std::make_shared<xlsxwriter::rel_tuple>();
+
+    relationship->type = "/image";
     relationship->target = filename;
 
     drawing_links.push_back(relationship);
+
+    drawing_object->rel_index = (uint16_t) drawing_links.size();
+    drawing_rel_ids[filename] = drawing_object->rel_index;
 }
 
 /*
@@ -1626,11 +1819,7 @@ void worksheet::prepare_chart(
     width = image_data->width * image_data->x_scale;
     height = image_data->height * image_data->y_scale;
 
-    /* Convert to the nearest pixel. */
-    image_data->width = width;
-    image_data->height = height;
-
-    _position_object_emus(image_data, drawing_object);
+    _position_object_emus(image_data, width, height, drawing_object);
 
     /* Convert from pixels to emus. */
     drawing_object->width = (uint32_t) (0.5 + width * 9525);
@@ -1649,11 +1838,69 @@ void worksheet::prepare_chart(
     drawing_links.push_back(relationship);
 }
 
+/*
+ * Reader for the image headers, from an image file or a memory buffer. It
+ * follows the stdio semantics that the header parsing was written for: a
+ * short read sets the end of file flag and a seek clears it.
+ */
+struct image_reader {
+    image_reader(FILE *stream)
+        : stream(stream), data(NULL), size(0), pos(0), at_end(false) {}
+
+    image_reader(const unsigned char *data, size_t size)
+        : stream(NULL), data(data), size(size), pos(0), at_end(false) {}
+
+    /* Read exactly n bytes. Returns false on a short read. */
+    bool read(void *buffer, size_t n)
+    {
+        if (stream)
+            return fread(buffer, 1, n, stream) == n;
+
+        if (pos > size || size - pos < n) {
+            pos = size;
+            at_end = true;
+            return false;
+        }
+
+        memcpy(buffer, data + pos, n);
+        pos += n;
+        return true;
+    }
+
+    /* Move by offset bytes from the current position. */
+    void seek(long offset)
+    {
+        if (stream) {
+            fseek(stream, offset, SEEK_CUR);
+            return;
+        }
+
+        if (offset < 0 && (size_t) -offset > pos)
+            pos = 0;
+        else
+            pos += offset;
+
+        at_end = false;
+    }
+
+    bool eof()
+    {
+        return stream ? feof(stream) != 0 : at_end;
+    }
+
+    FILE *stream;
+    const unsigned char *data;
+    size_t size;
+    size_t pos;
+    bool at_end;
+};
+
 /*
  * Extract width and height information from a PNG file.
  */
 lxw_error
-_process_png(const image_options_ptr& image_options)
+_process_png(const image_options_ptr& image_options,
+             image_reader& reader)
 {
     uint32_t length;
     uint32_t offset;
@@ -1663,18 +1910,16 @@ _process_png(const image_options_ptr& image_options)
     double x_dpi = 96;
     double y_dpi = 96;
 
-    FILE *stream = image_options->stream;
-
     /* Skip another 4 bytes to the end of the PNG header. */
-    fseek(stream, 4, SEEK_CUR);
+    reader.seek(4);
 
-    while (!feof(stream)) {
+    while (!reader.eof()) {
 
         /* Read the PNG length and type fields for the sub-section. */
-        if (fread(&length, sizeof(length), 1, stream) < 1)
+        if (!reader.read(&length, sizeof(length)))
             break;
 
-        if (fread(&type, 1, 4, stream) < 4)
+        if (!reader.read(&type, 4))
             break;
 
         /* Convert the length to network order. */
@@ -1684,10 +1929,10 @@ _process_png(const image_options_ptr& image_options)
         offset = length + 4;
 
         if (memcmp(type, "IHDR", 4) == 0) {
-            if (fread(&width, sizeof(width), 1, stream) < 1)
+            if (!reader.read(&width, sizeof(width)))
                 break;
 
-            if (fread(&height, sizeof(height), 1, stream) < 1)
+            if (!reader.read(&height, sizeof(height)))
                 break;
 
             width = LXW_UINT32_NETWORK(width);
@@ -1702,13 +1947,13 @@ _process_png(const image_options_ptr& image_options)
             uint32_t y_ppu = 0;
             uint8_t units = 1;
 
-            if (fread(&x_ppu, sizeof(x_ppu), 1, stream) < 1)
+            if (!reader.read(&x_ppu, sizeof(x_ppu)))
                 break;
 
-            if (fread(&y_ppu, sizeof(y_ppu), 1, stream) < 1)
+            if (!reader.read(&y_ppu, sizeof(y_ppu)))
                 break;
 
-            if (fread(&units, sizeof(units), 1, stream) < 1)
+            if (!reader.read(&units, sizeof(units)))
                 break;
 
             if (units == 1) {
@@ -1726,8 +1971,8 @@ _process_png(const image_options_ptr& image_options)
         if (memcmp(type, "IEND", 4) == 0)
             break;
 
-        if (!feof(stream))
-            fseek(stream, offset, SEEK_CUR);
+        if (!reader.eof())
+            reader.seek(offset);
     }
 
     /* Ensure that we read some valid data from the file. */
@@ -1753,7 +1998,8 @@ _process_png(const image_options_ptr& image_options)
  * Extract width and height information from a JPEG file.
  */
 lxw_error
-_process_jpeg(const image_options_ptr& image_options)
+_process_jpeg(const image_options_ptr& image_options,
+             image_reader& reader)
 {
     uint16_t length;
     uint16_t marker;
@@ -1763,20 +2009,18 @@ _process_jpeg(const image_options_ptr& image_options)
     double x_dpi = 96;
     double y_dpi = 96;
 
-    FILE *stream = image_options->stream;
-
     /* Read back 2 bytes to the end of the initial 0xFFD8 marker. */
-    fseek(stream, -2, SEEK_CUR);
+    reader.seek(-2);
 
     /* Search through the image data to read the height and width in the */
     /* 0xFFC0/C2 element. Also read the DPI in the 0xFFE0 element. */
-    while (!feof(stream)) {
+    while (!reader.eof()) {
 
         /* Read the JPEG marker and length fields for the sub-section. */
-        if (fread(&marker, sizeof(marker), 1, stream) < 1)
+        if (!reader.read(&marker, sizeof(marker)))
             break;
 
-        if (fread(&length, sizeof(length), 1, stream) < 1)
+        if (!reader.read(&length, sizeof(length)))
             break;
 
         /* Convert the marker and length to network order. */
@@ -1788,12 +2032,12 @@ _process_jpeg(const image_options_ptr& image_options)
 
         if (marker == 0xFFC0 || marker == 0xFFC2) {
             /* Skip 1 byte to height and width. */
-            fseek(stream, 1, SEEK_CUR);
+            reader.seek(1);
 
-            if (fread(&height, sizeof(height), 1, stream) < 1)
+            if (!reader.read(&height, sizeof(height)))
                 break;
 
-            if (fread(&width, sizeof(width), 1, stream) < 1)
+            if (!reader.read(&width, sizeof(width)))
                 break;
 
             height = LXW_UINT16_NETWORK(height);
@@ -1807,15 +2051,15 @@ _process_jpeg(const image_options_ptr& image_options)
             uint16_t y_density = 0;
             uint8_t units = 1;
 
-            fseek(stream, 7, SEEK_CUR);
+            reader.seek(7);
 
-            if (fread(&units, sizeof(units), 1, stream) < 1)
+            if (!reader.read(&units, sizeof(units)))
                 break;
 
-            if (fread(&x_density, sizeof(x_density), 1, stream) < 1)
+            if (!reader.read(&x_density, sizeof(x_density)))
                 break;
 
-            if (fread(&y_density, sizeof(y_density), 1, stream) < 1)
+            if (!reader.read(&y_density, sizeof(y_density)))
                 break;
 
             x_density = LXW_UINT16_NETWORK(x_density);
@@ -1837,8 +2081,8 @@ _process_jpeg(const image_options_ptr& image_options)
         if (marker == 0xFFDA)
             break;
 
-        if (!feof(stream))
-            fseek(stream, offset, SEEK_CUR);
+        if (!reader.eof())
+            reader.seek(offset);
     }
 
     /* Ensure that we read some valid data from the file. */
@@ -1864,22 +2108,21 @@ _process_jpeg(const image_options_ptr& image_options)
  * Extract width and height information from a BMP file.
  */
 lxw_error
-_process_bmp(const image_options_ptr& image_options)
+_process_bmp(const image_options_ptr& image_options,
+             image_reader& reader)
 {
     uint32_t width = 0;
     uint32_t height = 0;
     double x_dpi = 96;
     double y_dpi = 96;
 
-    FILE *stream = image_options->stream;
-
     /* Skip another 14 bytes to the start of the BMP height/width. */
-    fseek(stream, 14, SEEK_CUR);
+    reader.seek(14);
 
-    if (fread(&width, sizeof(width), 1, stream) < 1)
+    if (!reader.read(&width, sizeof(width)))
         width = 0;
 
-    if (fread(&height, sizeof(height), 1, stream) < 1)
+    if (!reader.read(&height, sizeof(height)))
         height = 0;
 
     /* Ensure that we read some valid data from the file. */
@@ -1905,12 +2148,13 @@ _process_bmp(const image_options_ptr& image_options)
  * Extract information from the image file such as dimension, type, filename,
  * and extension.
  */
-lxw_error _get_image_properties(const image_options_ptr& image_options)
+lxw_error _get_image_properties(const image_options_ptr& image_options,
+                                image_reader& reader)
 {
     unsigned char signature[4];
 
     /* Read 4 bytes to look for the file header/signature. */
-    if (fread(signature, 1, 4, image_options->stream) < 4) {
+    if (!reader.read(signature, 4)) {
         LXW_WARN_FORMAT1("worksheet_insert_image()/_opt(): "
                          "couldn't read file type for file: %s.",
                          image_options->filename.c_str());
@@ -1918,15 +2162,15 @@ lxw_error _get_image_properties(const image_options_ptr& image_options)
     }
 
     if (memcmp(&signature[1], "PNG", 3) == 0) {
-        if (_process_png(image_options) != LXW_NO_ERROR)
+        if (_process_png(image_options, reader) != LXW_NO_ERROR)
             return LXW_ERROR_IMAGE_DIMENSIONS;
     }
     else if (signature[0] == 0xFF && signature[1] == 0xD8) {
-        if (_process_jpeg(image_options) != LXW_NO_ERROR)
+        if (_process_jpeg(image_options, reader) != LXW_NO_ERROR)
             return LXW_ERROR_IMAGE_DIMENSIONS;
     }
     else if (memcmp(signature, "BM", 2) == 0) {
-        if (_process_bmp(image_options) != LXW_NO_ERROR)
+        if (_process_bmp(image_options, reader) != LXW_NO_ERROR)
             return LXW_ERROR_IMAGE_DIMENSIONS;
     }
     else {
@@ -1953,12 +2197,10 @@ void worksheet::_write_number_cell(const std::string& range,
                    int32_t style_index, lxw_cell *cell)
 {
     if (style_index)
-        fprintf(file,
-                "<c r=\"%s\" s=\"%d\"><v>%.16g</v></c>",
-                range.c_str(), style_index, cell->u.number);
+        file->print("<c r=\"%s\" s=\"%d\"><v>%.16g</v></c>",
+                    range.c_str(), style_index, cell->u.number);
     else
-        fprintf(file,
-                "<c r=\"%s\"><v>%.16g</v></c>", range.c_str(), cell->u.number);
+        file->print("<c r=\"%s\"><v>%.16g</v></c>", range.c_str(), cell->u.number);
 }
 
 /*
@@ -1969,13 +2211,12 @@ void worksheet::_write_string_cell(const std::string& range,
                    int32_t style_index, lxw_cell *cell)
 {
     if (style_index)
-        fprintf(file,
-                "<c r=\"%s\" s=\"%d\" t=\"s\"><v>%d</v></c>",
-                range.c_str(), style_index, cell->u.string_id);
+        file->print("<c r=\"%s\" s=\"%d\" t=\"s\"><v>%d</v></c>",
+                    range.c_str(), style_index,
+                    sst->get_final_index(cell->u.string_id));
     else
-        fprintf(file,
-                "<c r=\"%s\" t=\"s\"><v>%d</v></c>",
-                range.c_str(), cell->u.string_id);
+        file->print("<c r=\"%s\" t=\"s\"><v>%d</v></c>",
+                    range.c_str(), sst->get_final_index(cell->u.string_id));
 }
 
 /*
@@ -1992,25 +2233,21 @@ void worksheet::_write_inline_string_cell(const std::string& range,
         || isspace(string[string.size() - 1])) {
 
         if (style_index)
-            fprintf(file,
-                    "<c r=\"%s\" s=\"%d\" t=\"inlineStr\"><is>"
-                    "<t xml:space=\"preserve\">%s</t></is></c>",
-                    range.c_str(), style_index, string.c_str());
+            file->print("<c r=\"%s\" s=\"%d\" t=\"inlineStr\"><is>"
+                        "<t xml:space=\"preserve\">%s</t></is></c>",
+                        range.c_str(), style_index, string.c_str());
         else
-            fprintf(file,
-                    "<c r=\"%s\" t=\"inlineStr\"><is>"
-                    "<t xml:space=\"preserve\">%s</t></is></c>",
-                    range.c_str(), string.c_str());
+            file->print("<c r=\"%s\" t=\"inlineStr\"><is>"
+                        "<t xml:space=\"preserve\">%s</t></is></c>",
+                        range.c_str(), string.c_str());
     }
     else {
         if (style_index)
-            fprintf(file,
-                    "<c r=\"%s\" s=\"%d\" t=\"inlineStr\">"
-                    "<is><t>%s</t></is></c>", range.c_str(), style_index, string.c_str());
+            file->print("<c r=\"%s\" s=\"%d\" t=\"inlineStr\">"
+                        "<is><t>%s</t></is></c>", range.c_str(), style_index, string.c_str());
         else
-            fprintf(file,
-                    "<c r=\"%s\" t=\"inlineStr\">"
-                    "<is><t>%s</t></is></c>", range.c_str(), string.c_str());
+            file->print("<c r=\"%s\" t=\"inlineStr\">"
+                        "<is><t>%s</t></is></c>", range.c_str(), string.c_str());
     }
 }
 
@@ -2178,6 +2415,11 @@ void worksheet::_write_rows()
     int32_t block_num = -1;
     char spans[LXW_MAX_CELL_RANGE_LENGTH] = { 0 };
 
+    if (!merged_blank_ranges.empty()) {
+        _write_merged_rows();
+        return;
+    }
+
     for(auto it = table.begin(); it != table.end() ; ++it) {
         lxw_row *row = it->second;
         if (row->cells.empty()) {
@@ -2205,6 +2447,197 @@ void worksheet::_write_rows()
     }
 }
 
+/*
+ * Write out the worksheet data together with the blank cells of the merged
+ * ranges. The blank cells are written as if they had been stored with
+ * write_blank(), with cells written to the worksheet taking precedence, and
+ * the rows that only contain blank cells are added.
+ */
+void worksheet::_write_merged_rows()
+{
+    std::vector<lxw_merged_range *> pending;
+    std::vector<lxw_merged_range *> active;
+    char spans[LXW_MAX_CELL_RANGE_LENGTH] = { 0 };
+    int32_t block_num = -1;
+    size_t next_merge = 0;
+    lxw_row_t row_num = 0;
+    bool started = false;
+    auto it = table.begin();
+
+    for (const auto& merged_range : merged_blank_ranges)
+        pending.push_back(merged_range.get());
+
+    std::sort(pending.begin(), pending.end(),
+              [](const lxw_merged_range *a, const lxw_merged_range *b) {
+                  return a->first_row < b->first_row;
+              });
+
+    while (true) {
+        /* The next row is the next one in the table or in a merged range. */
+        bool found = false;
+        lxw_row_t next_row = 0;
+
+        if (it != table.end()) {
+            next_row = it->first;
+            found = true;
+        }
+
+        for (const auto& merged_range : active) {
+            if (merged_range->last_row > row_num) {
+                if (!found || row_num + 1 < next_row)
+                    next_row = row_num + 1;
+                found = true;
+                break;
+            }
+        }
+
+        if (next_merge < pending.size()
+            && (!found || pending[next_merge]->first_row < next_row)) {
+            next_row = pending[next_merge]->first_row;
+            found = true;
+        }
+
+        if (!found || (started && next_row <= row_num))
+            break;
+
+        row_num = next_row;
+        started = true;
+
+        /* Update the merged ranges that cover the row, in column order. */
+        active.erase(std::remove_if(active.begin(), active.end(),
+                                    [row_num](const lxw_merged_range *range) {
+                                        return range->last_row < row_num;
+                                    }),
+                     active.end());
+
+        while (next_merge < pending.size()
+               && pending[next_merge]->first_row <= row_num) {
+            lxw_merged_range *merged_range = pending[next_merge++];
+            auto pos = std::lower_bound(
+                           active.begin(), active.end(), merged_range,
+                           [](const lxw_merged_range *a,
+                              const lxw_merged_range *b) {
+                               return a->first_col < b->first_col;
+                           });
+            active.insert(pos, merged_range);
+        }
+
+        lxw_row *row = NULL;
+        if (it != table.end() && (lxw_row_t) it->first == row_num) {
+            row = it->second;
+            ++it;
+        }
+
+        if (row && row->cells.empty() && active.empty()) {
+            /* Row contains no cells but has height, format or other data. */
+
+            /* Write a default span for default rows. */
+            if (default_row_set)
+                _write_row(row, "1:1");
+            else
+                _write_row(row, "");
+
+            continue;
+        }
+
+        /* Calculate the spans of the block of 16 rows from this row. */
+        if ((int32_t) row_num / 16 > block_num) {
+            lxw_row_t block_end = row_num | 15;
+            lxw_col_t span_col_min = LXW_COL_MAX;
+            lxw_col_t span_col_max = 0;
+
+            for (auto span_it = row ? std::prev(it) : it;
+                 span_it != table.end() && (lxw_row_t) span_it->first <= block_end;
+                 ++span_it) {
+                const auto& cells = span_it->second->cells;
+
+                if (cells.empty())
+                    continue;
+
+                span_col_min = std::min(span_col_min, cells.begin()->first);
+                span_col_max = std::max(span_col_max, cells.rbegin()->first);
+            }
+
+            for (const auto& merged_range : active) {
+                span_col_min = std::min(span_col_min, merged_range->first_col);
+                span_col_max = std::max(span_col_max, merged_range->last_col);
+            }
+
+            for (size_t i = next_merge;
+                 i < pending.size() && pending[i]->first_row <= block_end; i++) {
+                span_col_min = std::min(span_col_min, pending[i]->first_col);
+                span_col_max = std::max(span_col_max, pending[i]->last_col);
+            }
+
+            block_num = row_num / 16;
+            lxw_snprintf(spans, LXW_MAX_CELL_RANGE_LENGTH,
+                         "%d:%d", span_col_min + 1, span_col_max + 1);
+        }
+
+        /* Rows that only have blank cells are written with the defaults
+         * of a new row. */
+        lxw_row new_row;
+        if (!row) {
+            new_row.row_num = row_num;
+            new_row.height = LXW_DEF_ROW_HEIGHT;
+            row = &new_row;
+        }
+
+        row->data_changed = true;
+        _write_row(row, spans);
+
+        const auto& cells = row->cells;
+        auto cell_it = cells.begin();
+
+        for (const auto& merged_range : active) {
+            while (cell_it != cells.end()
+                   && cell_it->first < merged_range->first_col) {
+                _write_cell(cell_it->second, row->format);
+                ++cell_it;
+            }
+
+            for (lxw_col_t col_num = merged_range->first_col;
+                 col_num <= merged_range->last_col; col_num++) {
+
+                if (cell_it != cells.end() && cell_it->first == col_num) {
+                    _write_cell(cell_it->second, row->format);
+                    ++cell_it;
+                }
+                else {
+                    lxw_cell blank;
+                    blank.row_num = row_num;
+                    blank.col_num = col_num;
+                    blank.type = BLANK_CELL;
+                    blank.format = merged_range->format;
+
+                    _write_cell(&blank, row->format);
+                }
+            }
+        }
+
+        for (; cell_it != cells.end(); ++cell_it)
+            _write_cell(cell_it->second, row->format);
+
+        lxw_xml_end_tag("row");
+    }
+}
+
+/*
+ * Check if a cell without data is one of the blank cells of a merged range.
+ */
+bool worksheet::_in_merged_blank_range(lxw_row_t row_num, lxw_col_t col_num)
+{
+    for (const auto& merged_range : merged_blank_ranges) {
+        if (row_num >= merged_range->first_row
+            && row_num <= merged_range->last_row
+            && col_num >= merged_range->first_col
+            && col_num <= merged_range->last_col)
+            return true;
+    }
+
+    return false;
+}
+
 /*
  * Write out the worksheet data as a single row with cells. This method is
  * used when memory optimization is on. A single row is written and the data
@@ -2780,6 +3213,11 @@ void worksheet::_write_drawings()
  */
 void worksheet::assemble_xml_file()
 {
+    /* Reset the relationships created while writing, in case the worksheet
+     * is assembled again by workbook::save(). */
+    rel_count = 0;
+    external_hyperlinks.clear();
+
     /* Write the XML declaration. */
     _xml_declaration();
 
@@ -2881,7 +3319,6 @@ worksheet::write_string(lxw_row_t row_num,
 {
     lxw_cell *cell;
     int32_t string_id;
-    sst_element *sst_element;
     lxw_error err;
 
     if (string.empty()) {
@@ -2900,28 +3337,14 @@ worksheet::write_string(lxw_row_t row_num,
     if (string.size() > LXW_STR_MAX)
         return LXW_ERROR_MAX_STRING_LENGTH_EXCEEDED;
 
-    if (!optimize) {
-        /* Get the SST element and string id. */
-        sst_element = sst->get_sst_index(string);
-
-        if (!sst_element)
-            return LXW_ERROR_SHARED_STRING_INDEX_NOT_FOUND;
-
-        string_id = sst_element->index;
-        cell = _new_string_cell(row_num, col_num, string_id, &sst_element->string, pformat);
+    if (!optimize && !_use_inline_string(col_num, string)) {
+        /* Get the SST string id. */
+        string_id = sst->get_sst_index(string);
+        cell = _new_string_cell(row_num, col_num, string_id, pformat);
     }
     else {
-        std::string *string_copy = new std::string();
-        /* Look for and escape control chars in the string. */
-        if (strpbrk(string.c_str(), "\x01\x02\x03\x04\x05\x06\x07\x08\x0B\x0C"
-                    "\x0D\x0E\x0F\x10\x11\x12\x13\x14\x15\x16"
-                    "\x17\x18\x19\x1A\x1B\x1C\x1D\x1E\x1F")) {
-            *string_copy = lxw_escape_control_characters(string);
-        }
-        else {
-            *string_copy = string;
-        }
-        cell = _new_inline_string_cell(row_num, col_num, string_copy, pformat);
+        cell = _new_inline_string_cell(row_num, col_num,
+                                       _copy_inline_string(string), pformat);
     }
 
     _insert_cell(row_num, col_num, cell);
@@ -2929,6 +3352,36 @@ worksheet::write_string(lxw_row_t row_num,
     return LXW_NO_ERROR;
 }
 
+/*
+ * Write a string interned with workbook::intern_string() to an Excel file.
+ */
+lxw_error
+worksheet::write_string(lxw_row_t row_num, lxw_col_t col_num,
+                        sst_handle string, format* pformat)
+{
+    lxw_cell *cell;
+    lxw_error err;
+
+    if (!string.valid() || !sst->has_string(string.index))
+        return LXW_ERROR_SHARED_STRING_INDEX_NOT_FOUND;
+
+    /* In constant memory mode the string is written inline. */
+    if (optimize)
+        return write_string(row_num, col_num,
+                            sst->get_string(string.index), pformat);
+
+    err = _check_dimensions(row_num, col_num, false, false);
+    if (err)
+        return err;
+
+    sst->add_reference(string.index);
+    cell = _new_string_cell(row_num, col_num, string.index, pformat);
+
+    _insert_cell(row_num, col_num, cell);
+
+    return LXW_NO_ERROR;
+}
+
 /*
  * Write a formula with a numerical result to a cell in Excel.
  */
@@ -3359,6 +3812,8 @@ lxw_error worksheet::set_column_opt(
     lxw_col_t col;
     lxw_error err;
 
+    dirty = true;
+
     /* Ensure second col is larger than first. */
     if (firstcol > lastcol) {
         lxw_col_t tmp = firstcol;
@@ -3409,12 +3864,32 @@ lxw_error worksheet::set_column_opt(
         col_formats[col] = pformat;
     }
 
+    /* Store the string storage of the columns, if it has been set. */
+    if (user_options.string_storage != LXW_STRING_STORAGE_DEFAULT
+        && lastcol >= col_string_storage.size()) {
+        col_string_storage.resize(lastcol + 1, LXW_STRING_STORAGE_DEFAULT);
+    }
+
+    for (col = firstcol; col <= lastcol && col < col_string_storage.size(); col++)
+        col_string_storage[col] = user_options.string_storage;
+
     /* Store the column change to allow optimizations. */
     col_size_changed = true;
 
     return LXW_NO_ERROR;
 }
 
+/*
+ * Set how the strings written to the worksheet are stored.
+ */
+void worksheet::set_string_storage(uint8_t storage)
+{
+    if (storage == LXW_STRING_STORAGE_DEFAULT)
+        storage = LXW_STRING_STORAGE_SHARED;
+
+    string_storage = storage;
+}
+
 /*
  * Set the properties of a single column or a range of columns.
  */
@@ -3436,6 +3911,8 @@ lxw_error worksheet::set_row_opt( lxw_row_t row_num, double height, format* pfor
     lxw_row *row;
     lxw_error err;
 
+    dirty = true;
+
     /* Use minimum col in _check_dimensions(). */
     if (dim_colmin != LXW_COL_MAX)
         min_col = dim_colmin;
@@ -3461,8 +3938,10 @@ lxw_error worksheet::set_row_opt( lxw_row_t row_num, double height, format* pfor
     row->collapsed = collapsed;
     row->row_changed = true;
 
-    if (height != default_row_height)
+    if (height != default_row_height) {
         row->height_changed = true;
+        row_size_changed = true;
+    }
 
     return LXW_NO_ERROR;
 }
@@ -3509,6 +3988,16 @@ lxw_error worksheet::merge_range(lxw_row_t first_row,
     if (err)
         return err;
 
+    /* Excel doesn't allow merged ranges to overlap. */
+    for (const auto& range : merged_ranges) {
+        if (first_row <= range->last_row && last_row >= range->first_row
+            && first_col <= range->last_col && last_col >= range->first_col) {
+            LXW_WARN("worksheet_merge_range(): "
+                     "merged range overlaps an earlier merged range.");
+            return LXW_ERROR_PARAMETER_VALIDATION;
+        }
+    }
+
     /* Store the merge range. */
     std::shared_ptr<lxw_merged_range> merged_range = std::make_shared<lxw_merged_range>();
 
@@ -3523,15 +4012,48 @@ lxw_error worksheet::merge_range(lxw_row_t first_row,
     /* Write the first cell */
     write_string(first_row, first_col, string, pformat);
 
-    /* Pad out the rest of the area with formatted blank cells. */
-    for (tmp_row = first_row; tmp_row <= last_row; tmp_row++) {
-        for (tmp_col = first_col; tmp_col <= last_col; tmp_col++) {
-            if (tmp_row == first_row && tmp_col == first_col)
+    /* Blank cells without formatting are ignored by Excel. */
+    if (!pformat)
+        return LXW_NO_ERROR;
+
+    /* Pad out the rest of the area with formatted blank cells. The rows are
+     * written in order in constant_memory mode, so the cells are stored. */
+    if (optimize) {
+        for (tmp_row = first_row; tmp_row <= last_row; tmp_row++) {
+            for (tmp_col = first_col; tmp_col <= last_col; tmp_col++) {
+                if (tmp_row == first_row && tmp_col == first_col)
+                    continue;
+                write_blank(tmp_row, tmp_col, pformat);
+            }
+        }
+
+        return LXW_NO_ERROR;
+    }
+
+    /* Otherwise the blank cells are written with the worksheet data. The
+     * cells already written to the area are replaced, as they would be by
+     * write_blank(), and cells written later take precedence. */
+    for (auto row_it = table.lower_bound(first_row);
+         row_it != table.end() && (lxw_row_t) row_it->first <= last_row;
+         ++row_it) {
+        auto& cells = row_it->second->cells;
+        auto cell_it = cells.lower_bound(first_col);
+
+        while (cell_it != cells.end() && cell_it->first <= last_col) {
+            if ((lxw_row_t) row_it->first == first_row
+                && cell_it->first == first_col) {
+                ++cell_it;
                 continue;
-            write_blank(tmp_row, tmp_col, pformat);
+            }
+
+            delete cell_it->second;
+            cell_it = cells.erase(cell_it);
         }
     }
 
+    merged_range->format = pformat;
+    merged_blank_ranges.push_back(merged_range);
+
     return LXW_NO_ERROR;
 }
 
@@ -3546,6 +4068,8 @@ lxw_error worksheet::autofilter(lxw_row_t first_row,
     lxw_col_t tmp_col;
     lxw_error err;
 
+    dirty = true;
+
     /* Excel doesn't allow a single cell to be merged */
     if (first_row == last_row && first_col == last_col)
         return LXW_ERROR_PARAMETER_VALIDATION;
@@ -3583,7 +4107,10 @@ lxw_error worksheet::autofilter(lxw_row_t first_row,
 void
 worksheet::select()
 {
+    dirty = true;
+
     selected = true;
+    default_selected = false;
 
     /* Selected worksheet can't be hidden. */
     hidden = false;
@@ -3596,7 +4123,10 @@ worksheet::select()
 void
 worksheet::activate()
 {
+    dirty = true;
+
     selected = true;
+    default_selected = false;
     active = true;
 
     /* Active worksheet can't be hidden. */
@@ -3625,17 +4155,20 @@ worksheet::set_first_sheet()
 void
 worksheet::hide()
 {
+    dirty = true;
+
     hidden = true;
 
     /* A hidden worksheet shouldn't be active or selected. */
     selected = false;
 
-    /* If this is active_sheet or first_sheet reset the workbook value. */
-    if (*first_sheet == index)
-        *first_sheet = 0;
+    /* If this is active_sheet or first_sheet reset the workbook value. Other
+     * worksheets may be setting them at the same time. */
+    uint16_t sheet_index = (uint16_t) index;
+    first_sheet->compare_exchange_strong(sheet_index, 0);
 
-    if (*active_sheet == index)
-        *active_sheet = 0;
+    sheet_index = (uint16_t) index;
+    active_sheet->compare_exchange_strong(sheet_index, 0);
 }
 
 /*
@@ -3649,6 +4182,8 @@ void worksheet::set_selection(lxw_row_t first_row, lxw_col_t first_col,
     std::string active_cell;
     std::string sqref;
 
+    dirty = true;
+
     /* Only allow selection to be set once to avoid freeing/re-creating it. */
     if (!selections.empty())
         return;
@@ -3696,6 +4231,8 @@ void worksheet::freeze_panes_opt( lxw_row_t first_row, lxw_col_t first_col,
                            lxw_row_t top_row, lxw_col_t left_col,
                            uint8_t type)
 {
+    dirty = true;
+
     panes.first_row = first_row;
     panes.first_col = first_col;
     panes.top_row = top_row;
@@ -3723,6 +4260,8 @@ void worksheet::freeze_panes(lxw_row_t first_row, lxw_col_t first_col)
 void worksheet::split_panes_opt(double y_split, double x_split,
                           lxw_row_t top_row, lxw_col_t left_col)
 {
+    dirty = true;
+
     panes.first_row = 0;
     panes.first_col = 0;
     panes.top_row = top_row;
@@ -3745,6 +4284,8 @@ void worksheet::split_panes(double y_split, double x_split)
  */
 void worksheet::set_portrait()
 {
+    dirty = true;
+
     orientation = LXW_PORTRAIT;
     page_setup_changed = true;
 }
@@ -3754,6 +4295,8 @@ void worksheet::set_portrait()
  */
 void worksheet::set_landscape()
 {
+    dirty = true;
+
     orientation = LXW_LANDSCAPE;
     page_setup_changed = true;
 }
@@ -3764,6 +4307,8 @@ void worksheet::set_landscape()
 void
 worksheet::set_page_view()
 {
+    dirty = true;
+
     page_view = true;
 }
 
@@ -3772,6 +4317,8 @@ worksheet::set_page_view()
  */
 void worksheet::set_paper(uint8_t paper_size)
 {
+    dirty = true;
+
     this->paper_size = paper_size;
     page_setup_changed = true;
 }
@@ -3781,6 +4328,8 @@ void worksheet::set_paper(uint8_t paper_size)
  */
 void worksheet::print_across()
 {
+    dirty = true;
+
     page_order = LXW_PRINT_ACROSS;
     page_setup_changed = true;
 }
@@ -3791,6 +4340,7 @@ void worksheet::print_across()
 void worksheet::set_margins(double left, double right,
                       double top, double bottom)
 {
+    dirty = true;
 
     if (left >= 0)
         margin_left = left;
@@ -3811,6 +4361,8 @@ void worksheet::set_margins(double left, double right,
 lxw_error worksheet::set_header_opt(const std::string& string,
                          const lxw_header_footer_options& options)
 {
+    dirty = true;
+
     if (options.margin > 0)
         margin_header = options.margin;
 
@@ -3833,6 +4385,8 @@ lxw_error worksheet::set_header_opt(const std::string& string,
 lxw_error
 worksheet::set_footer_opt(const std::string& string, const lxw_header_footer_options& options)
 {
+    dirty = true;
+
     if (options.margin > 0)
         margin_footer = options.margin;
 
@@ -3873,6 +4427,8 @@ worksheet::set_footer(const std::string& string)
 void
 worksheet::gridlines(uint8_t option)
 {
+    dirty = true;
+
     if (option == LXW_HIDE_ALL_GRIDLINES) {
         print_gridlines = 0;
         screen_gridlines = 0;
@@ -3894,6 +4450,8 @@ worksheet::gridlines(uint8_t option)
 void
 worksheet::center_horizontally()
 {
+    dirty = true;
+
     print_options_changed = 1;
     hcenter = 1;
 }
@@ -3904,6 +4462,8 @@ worksheet::center_horizontally()
 void
 worksheet::center_vertically()
 {
+    dirty = true;
+
     print_options_changed = 1;
     vcenter = 1;
 }
@@ -3914,6 +4474,8 @@ worksheet::center_vertically()
 void
 worksheet::print_row_col_headers()
 {
+    dirty = true;
+
     print_headers = 1;
     print_options_changed = 1;
 }
@@ -3928,6 +4490,8 @@ worksheet::repeat_rows(lxw_row_t first_row,
     lxw_row_t tmp_row;
     lxw_error err;
 
+    dirty = true;
+
     if (first_row > last_row) {
         tmp_row = last_row;
         last_row = first_row;
@@ -3955,6 +4519,8 @@ worksheet::repeat_columns(lxw_col_t first_col,
     lxw_col_t tmp_col;
     lxw_error err;
 
+    dirty = true;
+
     if (first_col > last_col) {
         tmp_col = last_col;
         last_col = first_col;
@@ -3984,6 +4550,8 @@ worksheet::print_area(lxw_row_t first_row,
     lxw_col_t tmp_col;
     lxw_error err;
 
+    dirty = true;
+
     if (first_row > last_row) {
         tmp_row = last_row;
         last_row = first_row;
@@ -4021,6 +4589,8 @@ worksheet::print_area(lxw_row_t first_row,
 void
 worksheet::fit_to_pages(uint16_t width, uint16_t height)
 {
+    dirty = true;
+
     fit_page = 1;
     fit_width = width;
     fit_height = height;
@@ -4033,6 +4603,8 @@ worksheet::fit_to_pages(uint16_t width, uint16_t height)
 void
 worksheet::set_start_page(uint16_t start_page)
 {
+    dirty = true;
+
     this->page_start = start_page;
 }
 
@@ -4042,6 +4614,8 @@ worksheet::set_start_page(uint16_t start_page)
 void
 worksheet::set_print_scale(uint16_t scale)
 {
+    dirty = true;
+
     /* Confine the scale to Excel"s range */
     if (scale < 10 || scale > 400)
         return;
@@ -4060,6 +4634,8 @@ lxw_error worksheet::set_h_pagebreaks(const std::vector<lxw_row_t>& hbreaks)
 {
     uint16_t count = hbreaks.size();
 
+    dirty = true;
+
     /* The Excel 2007 specification says that the maximum number of page
      * breaks is 1026. However, in practice it is actually 1023. */
     if (count > LXW_BREAKS_MAX)
@@ -4078,6 +4654,8 @@ lxw_error worksheet::set_v_pagebreaks(const std::vector<lxw_col_t>& vbreaks)
 {
     uint16_t count = vbreaks.size();
 
+    dirty = true;
+
     /* The Excel 2007 specification says that the maximum number of page
      * breaks is 1026. However, in practice it is actually 1023. */
     if (count > LXW_BREAKS_MAX)
@@ -4095,6 +4673,8 @@ lxw_error worksheet::set_v_pagebreaks(const std::vector<lxw_col_t>& vbreaks)
 void
 worksheet::set_zoom(uint16_t scale)
 {
+    dirty = true;
+
     /* Confine the scale to Excel"s range */
     if (scale < 10 || scale > 400) {
         LXW_WARN("worksheet_set_zoom(): "
@@ -4110,6 +4690,8 @@ worksheet::set_zoom(uint16_t scale)
  */
 void worksheet::hide_zero()
 {
+    dirty = true;
+
     show_zeros = false;
 }
 
@@ -4118,6 +4700,8 @@ void worksheet::hide_zero()
  */
 void worksheet::get_right_to_left()
 {
+    dirty = true;
+
     right_to_left = true;
 }
 
@@ -4127,6 +4711,8 @@ void worksheet::get_right_to_left()
 void
 worksheet::set_tab_color(lxw_color_t color)
 {
+    dirty = true;
+
     tab_color = color;
 }
 
@@ -4140,6 +4726,8 @@ worksheet::protect(const char *password,
 {
     struct lxw_protection *protect = &protection;
 
+    dirty = true;
+
     /* Copy any user parameters to the internal structure. */
     if (options)
         memcpy(protect, options, sizeof(lxw_protection));
@@ -4162,6 +4750,8 @@ void
 worksheet::set_default_row(double height,
                           uint8_t hide_unused_rows)
 {
+    dirty = true;
+
     if (height < 0)
         height = default_row_height;
 
@@ -4178,9 +4768,81 @@ worksheet::set_default_row(double height,
 
 void worksheet::set_vertical_dpi(size_t dpi)
 {
+    dirty = true;
+
     vertical_dpi = dpi;
 }
 
+/*
+ * Create the options of an inserted image from the user options.
+ */
+static image_options_ptr _new_image_options(lxw_row_t row_num,
+                                            lxw_col_t col_num,
+                                            image_options* user_options)
+{
+    image_options_ptr options = std::make_shared<image_options>();
+
+    if (user_options) {
+        *options = *user_options;
+        options->url = user_options->url;
+        options->tip = user_options->tip;
+    }
+
+    options->row = row_num;
+    options->col = col_num;
+
+    if (!options->x_scale)
+        options->x_scale = 1;
+
+    if (!options->y_scale)
+        options->y_scale = 1;
+
+    return options;
+}
+
+/*
+ * Read part of the data of an image from its buffer or its file.
+ */
+size_t image_options::read_data(FILE *stream, size_t offset,
+                                unsigned char *buffer, size_t size) const
+{
+    if (stream)
+        return fread(buffer, 1, size, stream);
+
+    if (offset >= image_buffer.size())
+        return 0;
+
+    if (size > image_buffer.size() - offset)
+        size = image_buffer.size() - offset;
+
+    memcpy(buffer, image_buffer.data() + offset, size);
+
+    return size;
+}
+
+/*
+ * Hash the data of an image file so that identical images can be stored
+ * once in the xlsx file.
+ */
+static void _hash_image_file(const image_options_ptr& options, FILE *stream)
+{
+    unsigned char buffer[LXW_BUFFER_SIZE];
+    uint64_t hash = lxw_hash_bytes(NULL, 0);
+    size_t size = 0;
+    size_t size_read;
+
+    rewind(stream);
+
+    while ((size_read = options->read_data(stream, size, buffer,
+                                           LXW_BUFFER_SIZE)) > 0) {
+        hash = lxw_hash_bytes(buffer, size_read, hash);
+        size += size_read;
+    }
+
+    options->data_hash = hash;
+    options->data_size = size;
+}
+
 /*
  * Insert an image into the worksheet.
  */
@@ -4191,6 +4853,9 @@ lxw_error worksheet::insert_image_opt(
 {
     FILE *image_stream;
     std::string short_name;
+    lxw_error error;
+
+    dirty = true;
 
     if (filename.empty()) {
         LXW_WARN("worksheet_insert_image()/_opt(): "
@@ -4212,38 +4877,73 @@ lxw_error worksheet::insert_image_opt(
     if (short_name.empty()) {
         LXW_WARN_FORMAT1("worksheet_insert_image()/_opt(): "
                          "couldn't get basename for file: %s.", filename.c_str());
+        fclose(image_stream);
         return LXW_ERROR_PARAMETER_VALIDATION;
     }
 
     /* Create a new object to hold the image options. */
-    image_options_ptr options = std::make_shared<image_options>();
-
-    if (user_options) {
-        *options = *user_options;
-        options->url = user_options->url;
-        options->tip = user_options->tip;
-    }
+    image_options_ptr options = _new_image_options(row_num, col_num,
+                                                   user_options);
 
-    /* Copy other options or set defaults. */
     options->filename = filename;
     options->short_name = short_name;
-    options->stream = image_stream;
-    options->row = row_num;
-    options->col = col_num;
 
-    if (!options->x_scale)
-        options->x_scale = 1;
+    if (!options->description.empty())
+        options->short_name = options->description;
 
-    if (!options->y_scale)
-        options->y_scale = 1;
+    /* The image data is only read here for its header and hash. The file
+     * is opened again to copy the data when the workbook is saved. */
+    image_reader reader(image_stream);
+    error = _get_image_properties(options, reader);
 
-    if (_get_image_properties(options) == LXW_NO_ERROR) {
-        image_data.push_back(options);
-        return LXW_NO_ERROR;
-    }
-    else {
+    if (error == LXW_NO_ERROR)
+        _hash_image_file(options, image_stream);
+
+    fclose(image_stream);
+
+    if (error != LXW_NO_ERROR)
         return LXW_ERROR_IMAGE_DIMENSIONS;
+
+    image_data.push_back(options);
+
+    return LXW_NO_ERROR;
+}
+
+/*
+ * Insert an image into the worksheet from a memory buffer.
+ */
+lxw_error worksheet::insert_image_buffer(lxw_row_t row_num, lxw_col_t col_num,
+                                         const uint8_t *image_buffer,
+                                         size_t image_size,
+                                         image_options* user_options)
+{
+    dirty = true;
+
+    if (!image_buffer || !image_size) {
+        LXW_WARN("worksheet_insert_image_buffer(): "
+                 "image buffer must be specified.");
+        return LXW_ERROR_NULL_PARAMETER_IGNORED;
     }
+
+    /* Create a new object to hold the image options. */
+    image_options_ptr options = _new_image_options(row_num, col_num,
+                                                   user_options);
+
+    options->filename = "image_buffer";
+    options->short_name = options->description;
+
+    image_reader reader(image_buffer, image_size);
+    if (_get_image_properties(options, reader) != LXW_NO_ERROR)
+        return LXW_ERROR_IMAGE_DIMENSIONS;
+
+    /* Keep a copy of the data for the xlsx file. */
+    options->image_buffer.assign(image_buffer, image_buffer + image_size);
+    options->data_hash = lxw_hash_bytes(image_buffer, image_size);
+    options->data_size = image_size;
+
+    image_data.push_back(options);
+
+    return LXW_NO_ERROR;
 }
 
 /*
@@ -4259,19 +4959,13 @@ lxw_error worksheet::insert_image( lxw_row_t row_num, lxw_col_t col_num, const s
  */
 lxw_error worksheet::insert_chart_opt(lxw_row_t row_num, lxw_col_t col_num, xlsxwriter::chart* chart, image_options* user_options)
 {
+    dirty = true;
+
     if (!chart) {
         LXW_WARN("worksheet_insert_chart()/_opt(): chart must be non-NULL.");
         return LXW_ERROR_NULL_PARAMETER_IGNORED;
     }
 
-    /* Check that the chart isn't being used more than once. */
-    if (chart->in_use) {
-        LXW_WARN("worksheet_insert_chart()/_opt(): the same chart object "
-                 "cannot be inserted in a worksheet more than once.");
-
-        return LXW_ERROR_PARAMETER_VALIDATION;
-    }
-
     /* Check that the chart has a data series. */
     if (chart->series_list.empty()) {
         LXW_WARN
@@ -4290,6 +4984,15 @@ lxw_error worksheet::insert_chart_opt(lxw_row_t row_num, lxw_col_t col_num, xlsx
         }
     }
 
+    /* Check that the chart isn't being used more than once. The chart is
+     * claimed atomically since other worksheets may be inserting it. */
+    if (chart->in_use.exchange(true)) {
+        LXW_WARN("worksheet_insert_chart()/_opt(): the same chart object "
+                 "cannot be inserted in a worksheet more than once.");
+
+        return LXW_ERROR_PARAMETER_VALIDATION;
+    }
+
     /* Create a new object to hold the chart image options. */
     image_options_ptr options = std::make_shared<image_options>();
 
@@ -4315,8 +5018,6 @@ lxw_error worksheet::insert_chart_opt(lxw_row_t row_num, lxw_col_t col_num, xlsx
 
     chart_data.push_back(options);
 
-    chart->in_use = true;
-
     return LXW_NO_ERROR;
 }
 
@@ -4328,6 +5029,315 @@ lxw_error worksheet::insert_chart(lxw_row_t row_num, lxw_col_t col_num, xlsxwrit
     return insert_chart_opt(row_num, col_num, chart, NULL);
 }
 
+/*
+ * Split the worksheet rows into bands that can be written from separate
+ * threads.
+ */
+std::vector<worksheet_band *> worksheet::partition(uint32_t num_bands,
+                                                   lxw_row_t rows_per_band)
+{
+    std::vector<worksheet_band *> band_list;
+    lxw_row_t first_row;
+    lxw_row_t end_row;
+    uint32_t i;
+
+    if (optimize || !num_bands)
+        return band_list;
+
+    if (!rows_per_band)
+        rows_per_band = (LXW_ROW_MAX + num_bands - 1) / num_bands;
+
+    if ((uint64_t) rows_per_band * (num_bands - 1) >= LXW_ROW_MAX)
+        return band_list;
+
+    /* Keep the cells written to the previous bands. */
+    _merge_bands();
+    bands.clear();
+
+    for (i = 0; i < num_bands; i++) {
+        first_row = i * rows_per_band;
+        end_row = first_row + rows_per_band;
+
+        if (end_row > LXW_ROW_MAX)
+            end_row = LXW_ROW_MAX;
+
+        bands.emplace_back(new worksheet_band(first_row, end_row));
+        band_list.push_back(bands.back().get());
+    }
+
+    return band_list;
+}
+
+/*****************************************************************************
+ *
+ * Worksheet band functions.
+ *
+ ****************************************************************************/
+
+/*
+ * Create a new worksheet band.
+ */
+worksheet_band::worksheet_band(lxw_row_t first_row, lxw_row_t end_row)
+    : first_row_(first_row)
+    , end_row_(end_row)
+    , dim_rowmin(LXW_ROW_MAX)
+    , dim_rowmax(0)
+    , dim_colmin(LXW_COL_MAX)
+    , dim_colmax(0)
+{
+    /* Initialize the cached row. */
+    table.cached_row_num = LXW_ROW_MAX + 1;
+}
+
+worksheet_band::~worksheet_band()
+{
+    for (auto it : table)
+        delete it.second;
+}
+
+/*
+ * Check that row and col are within the band and store max and min values
+ * for the worksheet dimensions.
+ */
+lxw_error worksheet_band::_check_dimensions(lxw_row_t row_num, lxw_col_t col_num)
+{
+    if (row_num < first_row_ || row_num >= end_row_)
+        return LXW_ERROR_WORKSHEET_INDEX_OUT_OF_RANGE;
+
+    if (col_num >= LXW_COL_MAX)
+        return LXW_ERROR_WORKSHEET_INDEX_OUT_OF_RANGE;
+
+    if (row_num < dim_rowmin)
+        dim_rowmin = row_num;
+    if (row_num > dim_rowmax)
+        dim_rowmax = row_num;
+    if (col_num < dim_colmin)
+        dim_colmin = col_num;
+    if (col_num > dim_colmax)
+        dim_colmax = col_num;
+
+    return LXW_NO_ERROR;
+}
+
+/*
+ * Insert a cell object into the rows of the band.
+ */
+void worksheet_band::_insert_cell(lxw_row_t row_num, lxw_col_t col_num, lxw_cell *cell)
+{
+    lxw_row *row = _get_row_list(table, row_num);
+
+    row->data_changed = true;
+    _insert_cell_list(row->cells, cell, col_num);
+}
+
+/*
+ * Write a number to a cell in the band.
+ */
+lxw_error worksheet_band::write_number(lxw_row_t row_num, lxw_col_t col_num,
+                                       double value, format* pformat)
+{
+    lxw_error err;
+
+    err = _check_dimensions(row_num, col_num);
+    if (err)
+        return err;
+
+    _insert_cell(row_num, col_num,
+                 _new_number_cell(row_num, col_num, value, pformat));
+
+    return LXW_NO_ERROR;
+}
+
+/*
+ * Write a string to a cell in the band. The string is kept in the band until
+ * the cell is moved into the worksheet.
+ */
+lxw_error worksheet_band::write_string(lxw_row_t row_num, lxw_col_t col_num,
+                                       const std::string& string, format* pformat)
+{
+    lxw_error err;
+
+    if (string.empty()) {
+        /* Treat an empty string with formatting as a blank cell. */
+        if (pformat)
+            return write_blank(row_num, col_num, pformat);
+        else
+            return LXW_ERROR_NULL_PARAMETER_IGNORED;
+    }
+
+    err = _check_dimensions(row_num, col_num);
+    if (err)
+        return err;
+
+    if (string.size() > LXW_STR_MAX)
+        return LXW_ERROR_MAX_STRING_LENGTH_EXCEEDED;
+
+    strings.push_back(string);
+
+    _insert_cell(row_num, col_num,
+                 _new_string_cell(row_num, col_num,
+                                  (int32_t) strings.size() - 1, pformat));
+
+    return LXW_NO_ERROR;
+}
+
+/*
+ * Write a formula with a numerical result to a cell in the band.
+ */
+lxw_error worksheet_band::write_formula_num(lxw_row_t row_num, lxw_col_t col_num,
+                                            const std::string& formula,
+                                            format* pformat, double result)
+{
+    lxw_cell *cell;
+    lxw_error err;
+
+    if (formula.empty())
+        return LXW_ERROR_NULL_PARAMETER_IGNORED;
+
+    err = _check_dimensions(row_num, col_num);
+    if (err)
+        return err;
+
+    /* Strip leading "=" from formula. */
+    cell = _new_formula_cell(row_num, col_num,
+                             new std::string(formula[0] == '=' ? formula.substr(1)
+                                                               : formula),
+                             pformat);
+    cell->formula_result = result;
+
+    _insert_cell(row_num, col_num, cell);
+
+    return LXW_NO_ERROR;
+}
+
+/*
+ * Write a formula with a default result to a cell in the band.
+ */
+lxw_error worksheet_band::write_formula(lxw_row_t row_num, lxw_col_t col_num,
+                                        const std::string& formula, format* pformat)
+{
+    return write_formula_num(row_num, col_num, formula, pformat, 0);
+}
+
+/*
+ * Write a blank cell with a format to a cell in the band.
+ */
+lxw_error worksheet_band::write_blank(lxw_row_t row_num, lxw_col_t col_num,
+                                      format* pformat)
+{
+    lxw_error err;
+
+    /* Blank cells without formatting are ignored by Excel. */
+    if (!pformat)
+        return LXW_NO_ERROR;
+
+    err = _check_dimensions(row_num, col_num);
+    if (err)
+        return err;
+
+    _insert_cell(row_num, col_num, _new_blank_cell(row_num, col_num, pformat));
+
+    return LXW_NO_ERROR;
+}
+
+/*
+ * Write a boolean to a cell in the band.
+ */
+lxw_error worksheet_band::write_boolean(lxw_row_t row_num, lxw_col_t col_num,
+                                        bool value, format* pformat)
+{
+    lxw_error err;
+
+    err = _check_dimensions(row_num, col_num);
+    if (err)
+        return err;
+
+    _insert_cell(row_num, col_num,
+                 _new_boolean_cell(row_num, col_num, value, pformat));
+
+    return LXW_NO_ERROR;
+}
+
+/*
+ * Write a date and or time to a cell in the band.
+ */
+lxw_error worksheet_band::write_datetime(lxw_row_t row_num, lxw_col_t col_num,
+                                         lxw_datetime *datetime, format* pformat)
+{
+    double excel_date = lxw_datetime_to_excel_date(datetime, LXW_EPOCH_1900);
+
+    return write_number(row_num, col_num, excel_date, pformat);
+}
+
+/*
+ * Create a new column string sketch.
+ */
+lxw_string_sketch::lxw_string_sketch()
+    : count(0)
+    , use_inline(false)
+{
+    memset(registers, 0, sizeof(registers));
+}
+
+/*
+ * Add the hash of a string to the sketch. The top bits of the hash pick a
+ * register, which keeps the longest run of leading zeros seen in the rest.
+ */
+void lxw_string_sketch::add(uint64_t hash)
+{
+    uint8_t rank = 1;
+    uint64_t bits;
+
+    /* Mix the bits since FNV-1a is weak in the top bits for short strings. */
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDULL;
+    hash ^= hash >> 33;
+    hash *= 0xC4CEB9FE1A85EC53ULL;
+    hash ^= hash >> 33;
+
+    bits = (hash << LXW_SKETCH_BITS) | (1ULL << (LXW_SKETCH_BITS - 1));
+
+    while (!(bits & (1ULL << 63))) {
+        bits <<= 1;
+        rank++;
+    }
+
+    uint8_t& reg = registers[hash >> (64 - LXW_SKETCH_BITS)];
+
+    if (rank > reg)
+        reg = rank;
+
+    count++;
+}
+
+/*
+ * Estimate the number of different strings added to the sketch.
+ */
+double lxw_string_sketch::estimate() const
+{
+    const double num_registers = 1 << LXW_SKETCH_BITS;
+    double alpha = 0.7213 / (1.0 + 1.079 / num_registers);
+    double sum = 0.0;
+    uint32_t zeros = 0;
+    double estimate;
+    size_t i;
+
+    for (i = 0; i < sizeof(registers); i++) {
+        sum += ldexp(1.0, -registers[i]);
+
+        if (!registers[i])
+            zeros++;
+    }
+
+    estimate = alpha * num_registers * num_registers / sum;
+
+    /* Use linear counting for small numbers of strings. */
+    if (estimate <= 2.5 * num_registers && zeros)
+        estimate = num_registers * log(num_registers / zeros);
+
+    return estimate;
+}
+
 lxw_row::lxw_row()
     : row_num(0)
     , height(0.0)
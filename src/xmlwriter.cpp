@@ -30,8 +30,8 @@ namespace xlsxwriter {
  */
 void xmlwriter::lxw_xml_declaration()
 {
-    fprintf(file, "<?xml version=\"1.0\" "
-            "encoding=\"UTF-8\" standalone=\"yes\"?>\n");
+    file->write("<?xml version=\"1.0\" "
+                "encoding=\"UTF-8\" standalone=\"yes\"?>\n");
 }
 
 /*
@@ -39,11 +39,11 @@ void xmlwriter::lxw_xml_declaration()
  */
 void xmlwriter::lxw_xml_start_tag(const std::string& tag, const std::list<std::pair<std::string, std::string>>& attributes)
 {
-    fprintf(file, "<%s", tag.c_str());
+    file->print("<%s", tag.c_str());
 
     _fprint_escaped_attributes(attributes);
 
-    fprintf(file, ">");
+    file->write(">", 1);
 }
 
 /*
@@ -52,13 +52,13 @@ void xmlwriter::lxw_xml_start_tag(const std::string& tag, const std::list<std::p
  */
 void xmlwriter::lxw_xml_start_tag_unencoded(const char *tag, const std::list<std::pair<std::string, std::string>>& attributes)
 {
-    fprintf(file, "<%s", tag);
+    file->print("<%s", tag);
 
     for (const auto& attribute : attributes) {
-        fprintf(file, " %s=\"%s\"", attribute.first.c_str(), attribute.second.c_str());
+        file->print(" %s=\"%s\"", attribute.first.c_str(), attribute.second.c_str());
     }
 
-    fprintf(file, ">");
+    file->write(">", 1);
 }
 
 /*
@@ -66,7 +66,7 @@ void xmlwriter::lxw_xml_start_tag_unencoded(const char *tag, const std::list<std
  */
 void xmlwriter::lxw_xml_end_tag(const std::string& tag)
 {
-    fprintf(file, "</%s>", tag.c_str());
+    file->print("</%s>", tag.c_str());
 }
 
 /*
@@ -74,11 +74,11 @@ void xmlwriter::lxw_xml_end_tag(const std::string& tag)
  */
 void xmlwriter::lxw_xml_empty_tag(const std::string&  tag, const std::list<std::pair<std::string, std::string>>& attributes)
 {
-    fprintf(file, "<%s", tag.c_str());
+    file->print("<%s", tag.c_str());
 
     _fprint_escaped_attributes(attributes);
 
-    fprintf(file, "/>");
+    file->write("/>", 2);
 }
 
 /*
@@ -87,11 +87,11 @@ void xmlwriter::lxw_xml_empty_tag(const std::string&  tag, const std::list<std::
  */
 void xmlwriter::lxw_xml_empty_tag_unencoded(const char *tag, const std::list<std::pair<std::string, std::string>>& attributes)
 {
-    fprintf(file, "<%s", tag);
+    file->print("<%s", tag);
     for (const auto& attribute : attributes) {
-        fprintf(file, " %s=\"%s\"", attribute.first.c_str(), attribute.second.c_str());
+        file->print(" %s=\"%s\"", attribute.first.c_str(), attribute.second.c_str());
     }
-    fprintf(file, "/>");
+    file->write("/>", 2);
 }
 
 /*
@@ -99,15 +99,15 @@ void xmlwriter::lxw_xml_empty_tag_unencoded(const char *tag, const std::list<std
  */
 void xmlwriter::lxw_xml_data_element(const std::string& tag, const std::string& data, const std::list<std::pair<std::string, std::string>>& attributes)
 {
-    fprintf(file, "<%s", tag.c_str());
+    file->print("<%s", tag.c_str());
 
     _fprint_escaped_attributes(attributes);
 
-    fprintf(file, ">");
+    file->write(">", 1);
 
     _fprint_escaped_data(data);
 
-    fprintf(file, "</%s>", tag.c_str());
+    file->print("</%s>", tag.c_str());
 }
 
 /*
@@ -238,16 +238,16 @@ std::string xmlwriter::lxw_escape_control_characters(const std::string& string)
 void xmlwriter::_fprint_escaped_attributes(const std::list<std::pair<std::string, std::string>>& attributes)
 {
     for (const auto& attribute : attributes) {
-        fprintf(file, " %s=", attribute.first.c_str());
+        file->print(" %s=", attribute.first.c_str());
 
         if (!strpbrk(attribute.second.c_str(), "&<>\"")) {
-            fprintf(file, "\"%s\"", attribute.second.c_str());
+            file->print("\"%s\"", attribute.second.c_str());
         }
         else {
             std::string encoded = _escape_attributes(attribute);
 
             if (!encoded.empty()) {
-                fprintf(file, "\"%s\"", encoded.c_str());
+                file->print("\"%s\"", encoded.c_str());
             }
         }
     }
@@ -258,12 +258,12 @@ void xmlwriter::_fprint_escaped_data(const std::string& data)
 {
     /* Escape the data section of the XML element. */
     if (!strpbrk(data.c_str(), "&<>")) {
-        fprintf(file, "%s", data.c_str());
+        file->write(data);
     }
     else {
         std::string encoded = lxw_escape_data(data);
         if (!encoded.empty()) {
-            fprintf(file, "%s", encoded.c_str());
+            file->write(encoded);
         }
     }
 }
@@ -0,0 +1,49 @@
+/*****************************************************************************
+ * Test cases for libxlsxwriter.
+ *
+ * Test case for chart series data set from arrays in constant memory mode.
+ *
+ * Copyright 2014-2016, John McNamara, jmcnamara@cpan.org
+ *
+ */
+
+#include "xlsxwriter.hpp"
+
+int main() {
+
+    xlsxwriter::workbook_options options;
+    options.constant_memory = true;
+
+    std::shared_ptr<xlsxwriter::workbook> workbook = std::make_shared<xlsxwriter::workbook>("test_chart_data01.xlsx", options);
+    xlsxwriter::worksheet *worksheet = workbook->add_worksheet();
+    xlsxwriter::chart     *chart     = workbook->add_chart( xlsxwriter::LXW_CHART_BAR);
+
+    /* For testing, copy the randomly generated axis ids in the target file. */
+    chart->axis_id_1 = 64052224;
+    chart->axis_id_2 = 64055552;
+
+    double data[3][5] = {
+        {1, 2,  3,  4,  5},
+        {2, 4,  6,  8,  10},
+        {3, 6,  9,  12, 15}
+    };
+
+    int row, col;
+    for (row = 0; row < 5; row++)
+        for (col = 0; col < 3; col++)
+            worksheet->write_number(row, col, data[col][row] , NULL);
+
+    /* The cells can't be read back in constant memory mode so the chart
+     * data cache is set from the arrays. */
+    xlsxwriter::chart_series *series1 = chart->add_series("=Sheet1!$A$1:$A$5", "=Sheet1!$B$1:$B$5");
+    xlsxwriter::chart_series *series2 = chart->add_series("=Sheet1!$A$1:$A$5", "=Sheet1!$C$1:$C$5");
+
+    series1->set_categories_data(data[0], 5);
+    series1->set_values_data(data[1], 5);
+    series2->set_categories_data(data[0], 5);
+    series2->set_values_data(data[2], 5);
+
+    worksheet->insert_chart(CELL("E9"), chart);
+
+    int result = workbook->close(); return result;
+}
@@ -0,0 +1,40 @@
+/*****************************************************************************
+ * Test cases for libxlsxwriter.
+ *
+ * Test case for a chart series with more than 65535 points.
+ *
+ * Copyright 2014-2016, John McNamara, jmcnamara@cpan.org
+ *
+ */
+
+#include "xlsxwriter.hpp"
+
+#define NUM_POINTS 70000
+
+int main() {
+
+    std::shared_ptr<xlsxwriter::workbook> workbook = std::make_shared<xlsxwriter::workbook>("test_chart_points01.xlsx");
+    xlsxwriter::worksheet *worksheet = workbook->add_worksheet();
+    xlsxwriter::chart     *chart     = workbook->add_chart( xlsxwriter::LXW_CHART_LINE);
+
+    chart->axis_id_1 = 43408000;
+    chart->axis_id_2 = 43434368;
+
+    /* Leave a gap and add a string to check the missing and string points. */
+    for (int row = 0; row < NUM_POINTS; row++) {
+        if (row == 1)
+            continue;
+
+        worksheet->write_number(row, 0, row, NULL);
+        worksheet->write_number(row, 1, row * 2, NULL);
+    }
+
+    worksheet->write_string(NUM_POINTS - 1, 2, "Last", NULL);
+
+    chart->add_series("=Sheet1!$C$1:$C$70000", "=Sheet1!$A$1:$A$70000");
+    chart->add_series("", "=Sheet1!$B$1:$B$70000");
+
+    worksheet->insert_chart(CELL("E9"), chart);
+
+    int result = workbook->close(); return result;
+}
@@ -0,0 +1,27 @@
+/*****************************************************************************
+ * Test cases for libxlsxwriter.
+ *
+ * Test case for closing the workbook on a background thread.
+ *
+ * Copyright 2014-2016, John McNamara, jmcnamara@cpan.org
+ *
+ */
+
+#include "xlsxwriter.hpp"
+
+int main() {
+
+    std::shared_ptr<xlsxwriter::workbook> workbook  = std::make_shared<xlsxwriter::workbook>("test_close_async01.xlsx");
+    xlsxwriter::worksheet *worksheet = workbook->add_worksheet();
+
+    worksheet->write_string(0, 0, "Hello", NULL);
+    worksheet->write_number(1, 0, 123,     NULL);
+
+    std::future<lxw_error> future = workbook->close_async();
+
+    /* The background close keeps its own reference to the workbook. */
+    workbook.reset();
+
+    int result = future.get();
+    return result;
+}
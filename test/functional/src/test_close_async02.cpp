@@ -0,0 +1,45 @@
+/*****************************************************************************
+ * Test cases for libxlsxwriter.
+ *
+ * Test case for closing the workbook on a user supplied executor with
+ * progress reporting.
+ *
+ * Copyright 2014-2016, John McNamara, jmcnamara@cpan.org
+ *
+ */
+
+#include "xlsxwriter.hpp"
+#include <thread>
+
+int main() {
+
+    std::shared_ptr<xlsxwriter::workbook> workbook  = std::make_shared<xlsxwriter::workbook>("test_close_async02.xlsx");
+    xlsxwriter::worksheet *worksheet = workbook->add_worksheet();
+
+    worksheet->write_string(0, 0, "Hello", NULL);
+    worksheet->write_number(1, 0, 123,     NULL);
+
+    std::thread worker;
+    uint32_t written = 0;
+    uint32_t total = 0;
+
+    xlsxwriter::close_options options;
+    options.executor = [&worker](const std::function<void()>& task) {
+        worker = std::thread(task);
+    };
+    options.progress = [&written, &total](uint32_t parts_written, uint32_t parts_total) {
+        written = parts_written;
+        total = parts_total;
+    };
+
+    std::future<lxw_error> future = workbook->close_async(options);
+
+    int result = future.get();
+    worker.join();
+
+    /* Every part of the package should have been reported. */
+    if (written == 0 || written != total)
+        return 1;
+
+    return result;
+}
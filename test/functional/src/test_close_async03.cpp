@@ -0,0 +1,66 @@
+/*****************************************************************************
+ * Test cases for libxlsxwriter.
+ *
+ * Test case for saving and closing the workbook again after a cancelled
+ * close.
+ *
+ * Copyright 2014-2016, John McNamara, jmcnamara@cpan.org
+ *
+ */
+
+#include "xlsxwriter.hpp"
+#include <thread>
+
+int main() {
+
+    std::shared_ptr<xlsxwriter::workbook> workbook  = std::make_shared<xlsxwriter::workbook>("test_close_async03.xlsx");
+    xlsxwriter::worksheet *worksheet = workbook->add_worksheet();
+
+    worksheet->write_string(0, 0, "Hello", NULL);
+    worksheet->write_number(1, 0, 123,     NULL);
+
+    /* A cancel after a save doesn't affect the next save. */
+    if (workbook->save("test_close_async03.xlsx") != LXW_NO_ERROR)
+        return 1;
+
+    workbook->cancel_close();
+
+    if (workbook->save("test_close_async03.xlsx") != LXW_NO_ERROR)
+        return 1;
+
+    /* Cancel a close before it starts. */
+    std::function<void()> pending;
+
+    xlsxwriter::close_options options;
+    options.executor = [&pending](const std::function<void()>& task) {
+        pending = task;
+    };
+
+    std::future<lxw_error> future = workbook->close_async(options);
+    workbook->cancel_close();
+    pending();
+
+    if (future.get() != LXW_ERROR_CLOSE_CANCELLED)
+        return 1;
+
+    /* Cancel a close while the package is being written. */
+    std::thread worker;
+
+    options.executor = [&worker](const std::function<void()>& task) {
+        worker = std::thread(task);
+    };
+    options.progress = [&workbook](uint32_t parts_written, uint32_t) {
+        if (parts_written == 1)
+            workbook->cancel_close();
+    };
+
+    future = workbook->close_async(options);
+    lxw_error error = future.get();
+    worker.join();
+
+    if (error != LXW_ERROR_CLOSE_CANCELLED)
+        return 1;
+
+    /* The workbook can still be closed. */
+    int result = workbook->close(); return result;
+}
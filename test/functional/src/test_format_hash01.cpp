@@ -0,0 +1,73 @@
+/*****************************************************************************
+ * Test cases for libxlsxwriter.
+ *
+ * Test case for the format hash table with a large number of distinct
+ * formats.
+ *
+ * Copyright 2014-2016, John McNamara, jmcnamara@cpan.org
+ *
+ */
+
+#include <stdio.h>
+
+#include "xlsxwriter.hpp"
+
+#define NUM_FORMATS  100000
+#define NUM_COLORS   320
+
+/*
+ * Add 100k formats that differ only in their font and fill colors, so that
+ * they share a small number of fonts and fills, and check that each gets its
+ * own XF index and that an identical format gets the existing index.
+ */
+static int test_distinct_formats()
+{
+    xlsxwriter::workbook     *workbook  = new xlsxwriter::workbook("test_format_hash01_big.xlsx");
+    xlsxwriter::worksheet    *worksheet = workbook->add_worksheet();
+    xlsxwriter::format      **formats   = new xlsxwriter::format*[NUM_FORMATS];
+    xlsxwriter::format       *duplicate;
+    int failures = 0;
+    int i;
+
+    for (i = 0; i < NUM_FORMATS; i++) {
+        formats[i] = workbook->add_format();
+        formats[i]->set_font_color(0x100000 + i % NUM_COLORS);
+        formats[i]->set_bg_color(0x200000 + i / NUM_COLORS);
+
+        worksheet->write_number(i, 0, i, formats[i]);
+
+        /* Index 0 is the default format. */
+        if (formats[i]->get_xf_index() != i + 1)
+            failures++;
+    }
+
+    duplicate = workbook->add_format();
+    duplicate->set_font_color(0x100000 + 12345 % NUM_COLORS);
+    duplicate->set_bg_color(0x200000 + 12345 / NUM_COLORS);
+
+    if (duplicate->get_xf_index() != formats[12345]->get_xf_index())
+        failures++;
+
+    if (workbook->close() != LXW_NO_ERROR)
+        failures++;
+
+    delete[] formats;
+    delete workbook;
+    remove("test_format_hash01_big.xlsx");
+
+    return failures;
+}
+
+int main() {
+
+    if (test_distinct_formats())
+        return 1;
+
+    std::shared_ptr<xlsxwriter::workbook> workbook  = std::make_shared<xlsxwriter::workbook>("test_format_hash01.xlsx");
+    xlsxwriter::worksheet *worksheet = workbook->add_worksheet();
+
+    worksheet->write_string(0, 0, "Hello", NULL);
+    worksheet->write_number(1, 0, 123,     NULL);
+
+    int result = workbook->close(); return result;
+}
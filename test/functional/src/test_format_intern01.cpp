@@ -0,0 +1,59 @@
+/*****************************************************************************
+ * Test cases for libxlsxwriter.
+ *
+ * Test case for formats created with workbook::intern_format().
+ *
+ * Copyright 2014-2016, John McNamara, jmcnamara@cpan.org
+ *
+ */
+
+#include "xlsxwriter.hpp"
+
+int main() {
+
+    std::shared_ptr<xlsxwriter::workbook> workbook  = std::make_shared<xlsxwriter::workbook>("test_format_intern01.xlsx");
+    xlsxwriter::worksheet *worksheet = workbook->add_worksheet();
+
+    xlsxwriter::format scratch;
+    scratch.set_left(xlsxwriter::LXW_BORDER_THIN);
+    scratch.set_top(xlsxwriter::LXW_BORDER_THIN);
+    scratch.set_bottom(xlsxwriter::LXW_BORDER_THIN);
+    xlsxwriter::format *top_left_bottom = workbook->intern_format(xlsxwriter::format_spec(scratch));
+
+    scratch.set_bottom(xlsxwriter::LXW_BORDER_NONE);
+    xlsxwriter::format *top_left = workbook->intern_format(xlsxwriter::format_spec(scratch));
+
+    scratch.set_left(xlsxwriter::LXW_BORDER_NONE);
+    scratch.set_bottom(xlsxwriter::LXW_BORDER_THIN);
+    xlsxwriter::format *top_bottom = workbook->intern_format(xlsxwriter::format_spec(scratch));
+
+    /* Identical specs should give the same format. */
+    scratch.set_left(xlsxwriter::LXW_BORDER_THIN);
+    if (workbook->intern_format(xlsxwriter::format_spec(scratch)) != top_left_bottom)
+        return 1;
+
+    if (xlsxwriter::format_spec(scratch) != xlsxwriter::format_spec(scratch))
+        return 1;
+
+    if (workbook->intern_format(xlsxwriter::format_spec()) == top_left)
+        return 1;
+
+    /* A shorter number format shouldn't leave the end of the longer one in
+     * the spec. */
+    xlsxwriter::format num_scratch;
+    num_scratch.set_num_format("0.000");
+    num_scratch.set_num_format("0.0");
+
+    xlsxwriter::format num_fresh;
+    num_fresh.set_num_format("0.0");
+
+    if (workbook->intern_format(xlsxwriter::format_spec(num_scratch))
+        != workbook->intern_format(xlsxwriter::format_spec(num_fresh)))
+        return 1;
+
+    worksheet->write_string(CELL("B2"), "test", top_left_bottom);
+    worksheet->write_string(CELL("D2"), "test", top_left);
+    worksheet->write_string(CELL("F2"), "test", top_bottom);
+
+    int result = workbook->close(); return result;
+}
@@ -0,0 +1,59 @@
+/*****************************************************************************
+ * Test cases for libxlsxwriter.
+ *
+ * Test the position of images and charts over overlapping column ranges,
+ * custom and hidden rows, and past the last sized row and column.
+ *
+ * Copyright 2014-2016, John McNamara, jmcnamara@cpan.org
+ *
+ */
+
+#include "xlsxwriter.hpp"
+
+int main() {
+
+    std::shared_ptr<xlsxwriter::workbook> workbook  = std::make_shared<xlsxwriter::workbook>("test_image36.xlsx");
+    xlsxwriter::worksheet *worksheet = workbook->add_worksheet();
+    xlsxwriter::chart     *chart     = workbook->add_chart(xlsxwriter::LXW_CHART_BAR);
+
+    /* For testing, use fixed axis ids. */
+    chart->axis_id_1 = 64052224;
+    chart->axis_id_2 = 64055552;
+
+    xlsxwriter::row_col_options hidden(true, 0, false);
+
+    /* Overlapping column ranges. The range with the lowest first column
+     * applies to a column in more than one range. */
+    worksheet->set_column(1, 8, 20, NULL);
+    worksheet->set_column(3, 4, 3, NULL);
+    worksheet->set_column(0, 2, 5, NULL);
+    worksheet->set_column_opt(10, 10, 0, NULL, hidden);
+
+    /* Custom, hidden and default height rows. */
+    worksheet->set_row(2, 30, NULL);
+    worksheet->set_row_opt(5, 0, NULL);
+    worksheet->set_row_opt(6, 25, NULL, hidden);
+    worksheet->set_row(9, 8.25, NULL);
+    worksheet->write_number(12, 0, 1, NULL);
+
+    xlsxwriter::image_options options = {};
+
+    worksheet->insert_image(CELL("A1"), "images/red.png");
+    worksheet->insert_image(CELL("E5"), "images/red.png");
+    worksheet->insert_image(CELL("L8"), "images/red.png");
+
+    /* Past the last sized row and column, with offsets across cells. */
+    options.x_offset = 200;
+    options.y_offset = 50;
+    worksheet->insert_image_opt(CELL("U31"), "images/red.png", &options);
+
+    options.x_offset = 150;
+    options.y_offset = 70;
+    worksheet->insert_image_opt(CELL("I9"), "images/red.png", &options);
+
+    worksheet->write_number(0, 0, 1, NULL);
+    chart->add_series("", "=Sheet1!$A$1:$A$1");
+    worksheet->insert_chart(CELL("N40"), chart);
+
+    int result = workbook->close(); return result;
+}
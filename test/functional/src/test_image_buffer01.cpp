@@ -0,0 +1,37 @@
+/*****************************************************************************
+ * Test cases for libxlsxwriter.
+ *
+ * Test to compare output against Excel files.
+ *
+ * Copyright 2014-2016, John McNamara, jmcnamara@cpan.org
+ *
+ */
+
+#include "xlsxwriter.hpp"
+
+int main() {
+
+    std::shared_ptr<xlsxwriter::workbook> workbook  = std::make_shared<xlsxwriter::workbook>("test_image_buffer01.xlsx");
+    xlsxwriter::worksheet *worksheet = workbook->add_worksheet();
+
+    /* Read the image into memory and insert it from there. */
+    std::vector<uint8_t> image;
+    uint8_t buffer[1024];
+    size_t size;
+
+    FILE *file = fopen("images/red.png", "rb");
+    if (!file)
+        return 1;
+
+    while ((size = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        image.insert(image.end(), buffer, buffer + size);
+
+    fclose(file);
+
+    xlsxwriter::image_options options;
+    options.description = "red.png";
+
+    worksheet->insert_image_buffer(CELL("E9"), image.data(), image.size(), &options);
+
+    int result = workbook->close(); return result;
+}
@@ -0,0 +1,39 @@
+/*****************************************************************************
+ * Test cases for libxlsxwriter.
+ *
+ * Test that identical images are stored once in the xlsx file.
+ *
+ * Copyright 2014-2016, John McNamara, jmcnamara@cpan.org
+ *
+ */
+
+#include "xlsxwriter.hpp"
+
+int main() {
+
+    std::shared_ptr<xlsxwriter::workbook> workbook  = std::make_shared<xlsxwriter::workbook>("test_image_dedup01.xlsx");
+    xlsxwriter::worksheet *worksheet1 = workbook->add_worksheet();
+    xlsxwriter::worksheet *worksheet2 = workbook->add_worksheet();
+
+    worksheet1->insert_image(CELL("E9"), "images/red.png");
+    worksheet1->insert_image(CELL("E20"), "images/blue.png");
+    worksheet1->insert_image(CELL("E30"), "images/red.png");
+
+    /* The same image from memory is stored with the file version. */
+    std::vector<uint8_t> image;
+    uint8_t buffer[1024];
+    size_t size;
+
+    FILE *file = fopen("images/red.png", "rb");
+    if (!file)
+        return 1;
+
+    while ((size = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        image.insert(image.end(), buffer, buffer + size);
+
+    fclose(file);
+
+    worksheet2->insert_image_buffer(CELL("E9"), image.data(), image.size());
+
+    int result = workbook->close(); return result;
+}
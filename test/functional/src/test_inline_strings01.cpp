@@ -0,0 +1,26 @@
+/*****************************************************************************
+ * Test cases for libxlsxwriter.
+ *
+ * Test case for writing inline strings outside of optimization mode.
+ *
+ * Copyright 2014-2016, John McNamara, jmcnamara@cpan.org
+ *
+ */
+
+#include "xlsxwriter.hpp"
+
+int main() {
+
+    std::shared_ptr<xlsxwriter::workbook> workbook  = std::make_shared<xlsxwriter::workbook>("test_inline_strings01.xlsx");
+    xlsxwriter::worksheet *worksheet = workbook->add_worksheet();
+
+    worksheet->set_string_storage(xlsxwriter::LXW_STRING_STORAGE_INLINE);
+
+    worksheet->write_string(0, 0, "Hello", NULL);
+    /* For testing overwrite the 0, 0 cell to ensure the original is freed. */
+    worksheet->write_string(0, 0, "Hello", NULL);
+
+    worksheet->write_number(1, 0, 123,     NULL);
+
+    int result = workbook->close(); return result;
+}
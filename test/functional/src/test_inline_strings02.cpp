@@ -0,0 +1,77 @@
+/*****************************************************************************
+ * Test cases for libxlsxwriter.
+ *
+ * Test case for adaptive shared/inline string storage.
+ *
+ * Copyright 2014-2016, John McNamara, jmcnamara@cpan.org
+ *
+ */
+
+#include <stdio.h>
+
+#include "xlsxwriter.hpp"
+
+/*
+ * Write a column of unique strings, a column of repeated strings and a column
+ * of unique strings that is forced to be shared. Only the first two should
+ * end up in the shared string table, along with the unique strings written
+ * before the first review of the adaptive column.
+ */
+static int test_adaptive_storage()
+{
+    xlsxwriter::workbook  *workbook  = new xlsxwriter::workbook("test_inline_strings02_big.xlsx");
+    xlsxwriter::worksheet *worksheet = workbook->add_worksheet();
+    xlsxwriter::row_col_options options;
+    char buffer[32];
+    int failures = 0;
+    uint32_t num_strings;
+    int i;
+
+    worksheet->set_string_storage(xlsxwriter::LXW_STRING_STORAGE_ADAPTIVE);
+
+    options.string_storage = xlsxwriter::LXW_STRING_STORAGE_SHARED;
+    worksheet->set_column_opt(2, 2, LXW_DEF_COL_WIDTH, NULL, options);
+
+    for (i = 0; i < 5000; i++) {
+        snprintf(buffer, sizeof(buffer), "Unique %d", i);
+        worksheet->write_string(i, 0, buffer, NULL);
+
+        snprintf(buffer, sizeof(buffer), "Repeated %d", i % 10);
+        worksheet->write_string(i, 1, buffer, NULL);
+
+        if (i < 1000) {
+            snprintf(buffer, sizeof(buffer), "Shared %d", i);
+            worksheet->write_string(i, 2, buffer, NULL);
+        }
+    }
+
+    /* The index of a new string is the number of strings in the table. */
+    num_strings = workbook->intern_string("Probe").index;
+
+    if (num_strings < 1010 || num_strings >= 1010 + LXW_SKETCH_INTERVAL)
+        failures++;
+
+    if (workbook->close())
+        failures++;
+
+    delete workbook;
+    remove("test_inline_strings02_big.xlsx");
+
+    return failures;
+}
+
+int main() {
+
+    if (test_adaptive_storage())
+        return 1;
+
+    std::shared_ptr<xlsxwriter::workbook> workbook  = std::make_shared<xlsxwriter::workbook>("test_inline_strings02.xlsx");
+    xlsxwriter::worksheet *worksheet = workbook->add_worksheet();
+
+    worksheet->set_string_storage(xlsxwriter::LXW_STRING_STORAGE_ADAPTIVE);
+
+    worksheet->write_string(0, 0, "Hello", NULL);
+    worksheet->write_number(1, 0, 123,     NULL);
+
+    int result = workbook->close(); return result;
+}
@@ -0,0 +1,92 @@
+/*****************************************************************************
+ * Test cases for libxlsxwriter.
+ *
+ * Test merged ranges against the same cells written one by one. The merged
+ * file and the reference file should have the same sheet and chart data.
+ *
+ * Copyright 2014-2016, John McNamara, jmcnamara@cpan.org
+ *
+ */
+
+#include "xlsxwriter.hpp"
+
+/* Merge a range, or write the cells that merge_range() used to store. */
+static lxw_error merge(xlsxwriter::worksheet *worksheet, bool merged,
+                       lxw_row_t first_row, lxw_col_t first_col,
+                       lxw_row_t last_row, lxw_col_t last_col,
+                       const std::string& string, xlsxwriter::format *format)
+{
+    if (merged)
+        return worksheet->merge_range(first_row, first_col, last_row, last_col,
+                                      string, format);
+
+    worksheet->write_string(first_row, first_col, string, format);
+
+    for (lxw_row_t row = first_row; row <= last_row; row++)
+        for (lxw_col_t col = first_col; col <= last_col; col++)
+            if (row != first_row || col != first_col)
+                worksheet->write_blank(row, col, format);
+
+    return LXW_NO_ERROR;
+}
+
+static int write_workbook(const char *filename, bool merged)
+{
+    std::shared_ptr<xlsxwriter::workbook> workbook = std::make_shared<xlsxwriter::workbook>(filename);
+    xlsxwriter::worksheet *worksheet = workbook->add_worksheet();
+    xlsxwriter::chart     *chart     = workbook->add_chart(xlsxwriter::LXW_CHART_LINE);
+
+    /* For testing, use fixed axis ids in both files. */
+    chart->axis_id_1 = 45740032;
+    chart->axis_id_2 = 45741568;
+
+    xlsxwriter::format *format = workbook->add_format();
+    format->set_align(xlsxwriter::LXW_ALIGN_CENTER);
+
+    /* Cells written before the merge are replaced inside the range and kept
+     * outside it. Cells written afterwards take precedence. */
+    worksheet->write_number(2, 1, 1, NULL);
+    worksheet->write_number(1, 5, 7, NULL);
+    merge(worksheet, merged, 1, 1, 3, 3, "Foo", format);
+    worksheet->write_number(2, 2, 5, NULL);
+    worksheet->write_number(3, 0, 9, NULL);
+
+    /* Rows that only contain merged blanks, one of them with a height. */
+    merge(worksheet, merged, 10, 1, 12, 4, "Bar", format);
+    worksheet->set_row(12, 30, NULL);
+
+    /* A range across two blocks of 16 rows, and the spans of the blocks. */
+    merge(worksheet, merged, 14, 6, 18, 8, "Baz", format);
+    worksheet->write_number(20, 0, 3, NULL);
+    merge(worksheet, merged, 40, 2, 41, 3, "Qux", format);
+    worksheet->write_number(47, 10, 1, NULL);
+
+    /* Overlapping merged ranges are rejected and change nothing. */
+    if (merged) {
+        if (worksheet->merge_range(2, 3, 5, 5, "Bad", format)
+            != LXW_ERROR_PARAMETER_VALIDATION)
+            return 1;
+
+        if (worksheet->merge_range(14, 8, 14, 9, "Bad", format)
+            != LXW_ERROR_PARAMETER_VALIDATION)
+            return 1;
+    }
+
+    /* The chart data cache reads the merged blanks. */
+    chart->add_series("", "=Sheet1!$C$2:$C$4");
+    chart->add_series("", "=Sheet1!$B$11:$E$11");
+
+    worksheet->insert_chart(CELL("M2"), chart);
+
+    return workbook->close();
+}
+
+int main() {
+
+    int result = write_workbook("test_merge_range06.xlsx", true);
+
+    if (result == 0)
+        result = write_workbook("test_merge_range06_ref.xlsx", false);
+
+    return result;
+}
@@ -0,0 +1,47 @@
+/*****************************************************************************
+ * Test cases for libxlsxwriter.
+ *
+ * Test case for reusing compressed files from the part cache.
+ *
+ * Copyright 2014-2016, John McNamara, jmcnamara@cpan.org
+ *
+ */
+
+#include "xlsxwriter.hpp"
+
+static int create_workbook(const xlsxwriter::workbook_options& options) {
+
+    std::shared_ptr<xlsxwriter::workbook> workbook  = std::make_shared<xlsxwriter::workbook>("test_part_cache01.xlsx", options);
+    xlsxwriter::worksheet *worksheet = workbook->add_worksheet();
+
+    worksheet->write_string(0, 0, "Hello", NULL);
+    worksheet->write_number(1, 0, 123,     NULL);
+
+    return workbook->close();
+}
+
+int main() {
+
+    xlsxwriter::part_cache& cache = xlsxwriter::part_cache::global();
+    xlsxwriter::workbook_options options;
+    options.use_part_cache = true;
+
+    int result = create_workbook(options);
+    if (result)
+        return result;
+
+    if (cache.hits() != 0 || cache.misses() == 0)
+        return 1;
+
+    /* The second, identical, workbook should be assembled from the cache. */
+    uint64_t misses = cache.misses();
+
+    result = create_workbook(options);
+    if (result)
+        return result;
+
+    if (cache.misses() != misses || cache.hits() != misses)
+        return 1;
+
+    return 0;
+}
@@ -0,0 +1,33 @@
+/*****************************************************************************
+ * Test cases for libxlsxwriter.
+ *
+ * Test case for the part cache memory budget.
+ *
+ * Copyright 2014-2016, John McNamara, jmcnamara@cpan.org
+ *
+ */
+
+#include "xlsxwriter.hpp"
+
+int main() {
+
+    xlsxwriter::part_cache& cache = xlsxwriter::part_cache::global();
+    cache.set_max_size(2048);
+
+    xlsxwriter::workbook_options options;
+    options.use_part_cache = true;
+
+    std::shared_ptr<xlsxwriter::workbook> workbook  = std::make_shared<xlsxwriter::workbook>("test_part_cache02.xlsx", options);
+    xlsxwriter::worksheet *worksheet = workbook->add_worksheet();
+
+    worksheet->write_string(0, 0, "Hello", NULL);
+    worksheet->write_number(1, 0, 123,     NULL);
+
+    int result = workbook->close();
+
+    /* Older parts should have been evicted to stay within the budget. */
+    if (cache.size() > 2048 || cache.evictions() == 0)
+        return 1;
+
+    return result;
+}
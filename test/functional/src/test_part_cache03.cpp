@@ -0,0 +1,93 @@
+/*****************************************************************************
+ * Test cases for libxlsxwriter.
+ *
+ * Test case for compressing spooled parts that fill the last output chunk
+ * exactly.
+ *
+ * Copyright 2014-2016, John McNamara, jmcnamara@cpan.org
+ *
+ */
+
+#include "xlsxwriter.hpp"
+
+#include <string.h>
+#include <string>
+
+/*
+ * Deflate a part that has been spilled to a tmpfile and compare it with the
+ * same part compressed in memory.
+ */
+static int test_spooled_part(const std::string& data) {
+
+    xlsxwriter::spool part(std::string(), 0);
+    part.write(data);
+
+    if (part.in_memory())
+        return 1;
+
+    xlsxwriter::part_cache_member_ptr spooled = xlsxwriter::part_cache::compress(part);
+    xlsxwriter::part_cache_member_ptr expected = xlsxwriter::part_cache::compress(data.data(), data.size());
+
+    if (!spooled || !expected)
+        return 1;
+
+    if (spooled->crc32 != expected->crc32
+        || spooled->uncompressed_size != data.size()
+        || spooled->deflated != expected->deflated)
+        return 1;
+
+    return 0;
+}
+
+int main() {
+
+    std::string data;
+    uint32_t seed = 1;
+    int found = 0;
+    size_t size;
+    int i;
+
+    for (size = 0; size < 4 * LXW_PART_CACHE_BUFFER_SIZE; size++) {
+        seed = seed * 1103515245 + 12345;
+        data.push_back((char) (seed >> 16));
+    }
+
+    /* Find parts of random data whose deflated size is a multiple of the
+     * chunk size, so that the last chunk of output is filled exactly. The
+     * deflated data is a little larger than the data. */
+    for (i = 1; i < 4; i++) {
+        size_t target = i * LXW_PART_CACHE_BUFFER_SIZE;
+
+        for (size = target - 64; size < target; size++) {
+            xlsxwriter::part_cache_member_ptr member = xlsxwriter::part_cache::compress(data.data(), size);
+            if (!member)
+                return 1;
+
+            if (member->deflated.size() > target)
+                break;
+
+            if (member->deflated.size() == target) {
+                if (test_spooled_part(data.substr(0, size)))
+                    return 1;
+
+                found++;
+                break;
+            }
+        }
+    }
+
+    if (!found)
+        return 1;
+
+    /* Worksheets kept by save() are compressed from the spooled parts. */
+    xlsxwriter::workbook_options options;
+    options.spool_threshold = 0;
+
+    std::shared_ptr<xlsxwriter::workbook> workbook  = std::make_shared<xlsxwriter::workbook>("test_part_cache03.xlsx", options);
+    xlsxwriter::worksheet *worksheet = workbook->add_worksheet();
+
+    worksheet->write_string(0, 0, "Hello", NULL);
+    worksheet->write_number(1, 0, 123,     NULL);
+
+    int result = workbook->save("test_part_cache03.xlsx"); return result;
+}
@@ -0,0 +1,32 @@
+/*****************************************************************************
+ * Test cases for libxlsxwriter.
+ *
+ * Test case for saving a workbook more than once.
+ *
+ * Copyright 2014-2016, John McNamara, jmcnamara@cpan.org
+ *
+ */
+
+#include "xlsxwriter.hpp"
+
+int main() {
+
+    std::shared_ptr<xlsxwriter::workbook> workbook  = std::make_shared<xlsxwriter::workbook>("test_save01.xlsx");
+    xlsxwriter::worksheet *worksheet = workbook->add_worksheet();
+
+    worksheet->write_string(0, 0, "Hello", NULL);
+
+    int result = workbook->save("test_save01.xlsx");
+    if (result)
+        return result;
+
+    /* Change the worksheet but not the shared strings. */
+    worksheet->write_number(1, 0, 123, NULL);
+
+    result = workbook->save("test_save01.xlsx");
+    if (result)
+        return result;
+
+    /* Save again without changes. */
+    return workbook->save("test_save01.xlsx");
+}
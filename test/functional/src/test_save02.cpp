@@ -0,0 +1,49 @@
+/*****************************************************************************
+ * Test cases for libxlsxwriter.
+ *
+ * Test case for saving a workbook with a chart more than once.
+ *
+ * Copyright 2014-2016, John McNamara, jmcnamara@cpan.org
+ *
+ */
+
+#include "xlsxwriter.hpp"
+
+int main() {
+
+    std::shared_ptr<xlsxwriter::workbook> workbook = std::make_shared<xlsxwriter::workbook>("test_save02.xlsx");
+    xlsxwriter::worksheet *worksheet = workbook->add_worksheet();
+    xlsxwriter::chart     *chart     = workbook->add_chart( xlsxwriter::LXW_CHART_BAR);
+
+    /* For testing, copy the randomly generated axis ids in the target file. */
+    chart->axis_id_1 = 64052224;
+    chart->axis_id_2 = 64055552;
+
+    uint8_t data[5][3] = {
+        {1, 2,  3},
+        {2, 4,  6},
+        {3, 6,  9},
+        {4, 8,  12},
+        {5, 10, 15}
+    };
+
+    int row, col;
+    for (row = 0; row < 5; row++)
+        for (col = 0; col < 2; col++)
+            worksheet->write_number(row, col, data[row][col] , NULL);
+
+    chart->add_series("=Sheet1!$A$1:$A$5", "=Sheet1!$B$1:$B$5");
+    chart->add_series("=Sheet1!$A$1:$A$5", "=Sheet1!$C$1:$C$5");
+
+    worksheet->insert_chart(CELL("E9"), chart);
+
+    int result = workbook->save("test_save02.xlsx");
+    if (result)
+        return result;
+
+    /* The chart data cache should pick up the new column. */
+    for (row = 0; row < 5; row++)
+        worksheet->write_number(row, 2, data[row][2] , NULL);
+
+    return workbook->save("test_save02.xlsx");
+}
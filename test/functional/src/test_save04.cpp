@@ -0,0 +1,37 @@
+/*****************************************************************************
+ * Test cases for libxlsxwriter.
+ *
+ * Test case for saving a workbook with several worksheets and shared strings ordered by frequency
+ * more than once.
+ *
+ * Copyright 2014-2016, John McNamara, jmcnamara@cpan.org
+ *
+ */
+
+#include "xlsxwriter.hpp"
+
+int main() {
+
+    xlsxwriter::workbook_options options;
+    options.order_strings_by_frequency = true;
+
+    std::shared_ptr<xlsxwriter::workbook> workbook  = std::make_shared<xlsxwriter::workbook>("test_save04.xlsx", options);
+    xlsxwriter::worksheet *worksheet1 = workbook->add_worksheet();
+    xlsxwriter::worksheet *worksheet2 = workbook->add_worksheet();
+
+    worksheet1->write_string(0, 0, "Foo");
+    worksheet2->write_string(0, 0, "Bar");
+    worksheet2->write_string(1, 0, "Bar");
+
+    int result = workbook->save("test_save04.xlsx");
+    if (result)
+        return result;
+
+    /* "Foo" becomes the most used string, so the strings of the unchanged
+     * second worksheet move. */
+    int row;
+    for (row = 1; row < 4; row++)
+        worksheet1->write_string(row, 0, "Foo");
+
+    return workbook->save("test_save04.xlsx");
+}
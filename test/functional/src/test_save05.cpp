@@ -0,0 +1,35 @@
+/*****************************************************************************
+ * Test cases for libxlsxwriter.
+ *
+ * Test case for saving a workbook with several worksheets and a concurrent shared string table
+ * more than once.
+ *
+ * Copyright 2014-2016, John McNamara, jmcnamara@cpan.org
+ *
+ */
+
+#include "xlsxwriter.hpp"
+
+int main() {
+
+    xlsxwriter::workbook_options options;
+    options.concurrent_strings = true;
+
+    std::shared_ptr<xlsxwriter::workbook> workbook  = std::make_shared<xlsxwriter::workbook>("test_save05.xlsx", options);
+    xlsxwriter::worksheet *worksheet1 = workbook->add_worksheet();
+    xlsxwriter::worksheet *worksheet2 = workbook->add_worksheet();
+
+    worksheet1->write_string(0, 0, "Foo");
+    worksheet2->write_string(0, 0, "Bar");
+    worksheet2->write_string(1, 0, "Bar");
+
+    int result = workbook->save("test_save05.xlsx");
+    if (result)
+        return result;
+
+    /* "Baz" is used before "Bar" in worksheet order, so the strings of the
+     * unchanged second worksheet move. */
+    worksheet1->write_string(1, 0, "Baz");
+
+    return workbook->save("test_save05.xlsx");
+}
@@ -0,0 +1,34 @@
+/*****************************************************************************
+ * Test cases for libxlsxwriter.
+ *
+ * Test case for saving a workbook with a chart that refers to a worksheet
+ * that is only added after the first save.
+ *
+ * Copyright 2014-2016, John McNamara, jmcnamara@cpan.org
+ *
+ */
+
+#include "xlsxwriter.hpp"
+
+int main() {
+
+    std::shared_ptr<xlsxwriter::workbook> workbook  = std::make_shared<xlsxwriter::workbook>("test_save06.xlsx");
+    xlsxwriter::worksheet *worksheet = workbook->add_worksheet();
+    xlsxwriter::chart     *chart     = workbook->add_chart(xlsxwriter::LXW_CHART_COLUMN);
+
+    chart->add_series("", "=Data!$A$1:$A$3");
+    worksheet->insert_chart(CELL("E9"), chart);
+
+    /* The range can't be read yet, so the chart has no cached data. */
+    int result = workbook->save("test_save06.xlsx");
+    if (result)
+        return result;
+
+    xlsxwriter::worksheet *data = workbook->add_worksheet("Data");
+
+    data->write_number(0, 0, 10);
+    data->write_number(1, 0, 20);
+    data->write_number(2, 0, 30);
+
+    return workbook->save("test_save06.xlsx");
+}
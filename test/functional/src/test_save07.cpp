@@ -0,0 +1,46 @@
+/*****************************************************************************
+ * Test cases for libxlsxwriter.
+ *
+ * Test case for activating a different worksheet between saves.
+ *
+ * Copyright 2014-2016, John McNamara, jmcnamara@cpan.org
+ *
+ */
+
+#include "xlsxwriter.hpp"
+
+int main() {
+
+    std::shared_ptr<xlsxwriter::workbook> workbook  = std::make_shared<xlsxwriter::workbook>("test_save07.xlsx");
+    xlsxwriter::worksheet *worksheet1 = workbook->add_worksheet();
+    xlsxwriter::worksheet *worksheet2 = workbook->add_worksheet("Data Sheet");
+    xlsxwriter::worksheet *worksheet3 = workbook->add_worksheet();
+
+    xlsxwriter::format *bold = workbook->add_format();
+    bold->set_bold();
+
+    worksheet1->write_string(CELL("A1"), "Foo" , NULL);
+    worksheet1->write_number(CELL("A2"), 123 , NULL);
+
+    worksheet3->write_string(CELL("B2"), "Foo" , NULL);
+    worksheet3->write_string(CELL("B3"), "Bar", bold);
+    worksheet3->write_number(CELL("C4"), 234 , NULL);
+
+    /* The first worksheet is selected and active by default. */
+    int result = workbook->save("test_save07.xlsx");
+    if (result)
+        return result;
+
+    worksheet2->activate();
+    result = workbook->save("test_save07.xlsx");
+    if (result)
+        return result;
+
+    /* The first worksheet, and the second as the active worksheet, should
+     * be reset. */
+    worksheet2->select();
+    worksheet3->select();
+    worksheet3->activate();
+
+    return workbook->save("test_save07.xlsx");
+}
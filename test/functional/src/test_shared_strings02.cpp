@@ -0,0 +1,62 @@
+/*****************************************************************************
+ * Test cases for libxlsxwriter.
+ *
+ * Test case for a shared string table that spans several arena blocks.
+ *
+ * Copyright 2014-2016, John McNamara, jmcnamara@cpan.org
+ *
+ */
+
+#include <stdio.h>
+
+#include "xlsxwriter.hpp"
+
+/*
+ * Write enough unique and repeated strings, including some of the maximum
+ * length, to fill several SST blocks and grow the index a number of times.
+ */
+static int test_large_sst()
+{
+    xlsxwriter::workbook  *workbook  = new xlsxwriter::workbook("test_shared_strings02_big.xlsx");
+    xlsxwriter::worksheet *worksheet = workbook->add_worksheet();
+    std::string long_string(32767, 'x');
+    char buffer[32];
+    int failures = 0;
+    int i;
+
+    for (i = 0; i < 50000; i++) {
+        snprintf(buffer, sizeof(buffer), "String %d", i % 20000);
+
+        if (worksheet->write_string(i, 0, buffer, NULL))
+            failures++;
+    }
+
+    for (i = 0; i < 8; i++) {
+        long_string[0] = 'a' + i;
+
+        if (worksheet->write_string(i, 1, long_string, NULL))
+            failures++;
+    }
+
+    if (workbook->close())
+        failures++;
+
+    delete workbook;
+    remove("test_shared_strings02_big.xlsx");
+
+    return failures;
+}
+
+int main() {
+
+    if (test_large_sst())
+        return 1;
+
+    std::shared_ptr<xlsxwriter::workbook> workbook  = std::make_shared<xlsxwriter::workbook>("test_shared_strings02.xlsx");
+    xlsxwriter::worksheet *worksheet = workbook->add_worksheet();
+
+    worksheet->write_string(0, 0, "Hello", NULL);
+    worksheet->write_number(1, 0, 123,     NULL);
+
+    int result = workbook->close(); return result;
+}
@@ -0,0 +1,53 @@
+/*****************************************************************************
+ * Test cases for libxlsxwriter.
+ *
+ * Test case for strings interned with workbook::intern_string().
+ *
+ * Copyright 2014-2016, John McNamara, jmcnamara@cpan.org
+ *
+ */
+
+#include "xlsxwriter.hpp"
+
+int main() {
+
+    std::shared_ptr<xlsxwriter::workbook> workbook  = std::make_shared<xlsxwriter::workbook>("test_shared_strings03.xlsx");
+    xlsxwriter::worksheet *worksheet1 = workbook->add_worksheet();
+    xlsxwriter::worksheet *worksheet2 = workbook->add_worksheet("Data Sheet");
+    xlsxwriter::worksheet *worksheet3 = workbook->add_worksheet();
+
+    xlsxwriter::format    *format     = workbook->add_format();
+    format->set_bold();
+
+    xlsxwriter::sst_handle foo = workbook->intern_string("Foo");
+    xlsxwriter::sst_handle bar = workbook->intern_string("Bar");
+
+    /* Interning again should give the same handle. */
+    if (workbook->intern_string("Foo").index != foo.index)
+        return 1;
+
+    /* Strings that can't be interned. */
+    if (workbook->intern_string("").valid())
+        return 1;
+
+    if (workbook->intern_string(std::string(32768, 'x')).valid())
+        return 1;
+
+    if (worksheet1->write_string(0, 1, xlsxwriter::sst_handle(), NULL)
+        != LXW_ERROR_SHARED_STRING_INDEX_NOT_FOUND)
+        return 1;
+
+    if (worksheet1->write_string(0, 1, xlsxwriter::sst_handle(1000), NULL)
+        != LXW_ERROR_SHARED_STRING_INDEX_NOT_FOUND)
+        return 1;
+
+    worksheet1->write_string(0, 0, foo);
+    worksheet1->write_number(1, 0, 123);
+    worksheet3->write_string(1, 1, foo);
+    worksheet3->write_string(2, 1, bar, format);
+    worksheet3->write_number(3, 2, 234);
+
+    (void)worksheet2; /* Unused. For testing only. */
+
+    int result = workbook->close(); return result;
+}
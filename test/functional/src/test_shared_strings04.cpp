@@ -0,0 +1,80 @@
+/*****************************************************************************
+ * Test cases for libxlsxwriter.
+ *
+ * Test case for worksheets written from several threads with a concurrent
+ * shared string table.
+ *
+ * Copyright 2014-2016, John McNamara, jmcnamara@cpan.org
+ *
+ */
+
+#include "xlsxwriter.hpp"
+
+#include <thread>
+#include <vector>
+
+#define NUM_THREADS 8
+#define NUM_STRINGS 2000
+
+int main() {
+
+    xlsxwriter::workbook_options options;
+    options.concurrent_strings = true;
+
+    std::shared_ptr<xlsxwriter::workbook> workbook  = std::make_shared<xlsxwriter::workbook>("test_shared_strings04.xlsx", options);
+    xlsxwriter::worksheet *worksheet1 = workbook->add_worksheet();
+    xlsxwriter::worksheet *worksheet2 = workbook->add_worksheet("Data Sheet");
+    xlsxwriter::worksheet *worksheet3 = workbook->add_worksheet();
+
+    xlsxwriter::format    *format     = workbook->add_format();
+    format->set_bold();
+
+    /* Intern the same strings from several threads. Every thread should get
+     * the same handles. The strings aren't used by any cells so they aren't
+     * written to the file. */
+    std::vector<std::vector<uint32_t> > indices(NUM_THREADS);
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < NUM_THREADS; i++) {
+        threads.push_back(std::thread([&workbook, &indices, i]() {
+            for (int j = 0; j < NUM_STRINGS; j++) {
+                int n = (i % 2) ? NUM_STRINGS - 1 - j : j;
+                indices[i].push_back(workbook->intern_string("String " + std::to_string(n)).index);
+            }
+        }));
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    for (int i = 1; i < NUM_THREADS; i++) {
+        for (int j = 0; j < NUM_STRINGS; j++) {
+            if (indices[i][j] != indices[i % 2][j])
+                return 1;
+        }
+    }
+
+    /* Write the sheets from separate threads. "Bar" is added to the table
+     * before "Foo" but the strings are numbered in the order that the cells
+     * use them. */
+    xlsxwriter::sst_handle bar = workbook->intern_string("Bar");
+
+    std::thread thread1([worksheet1]() {
+        worksheet1->write_string(0, 0, "Foo");
+        worksheet1->write_number(1, 0, 123);
+    });
+
+    std::thread thread3([worksheet3]() {
+        worksheet3->write_string(1, 1, "Foo");
+        worksheet3->write_number(3, 2, 234);
+    });
+
+    thread1.join();
+    thread3.join();
+
+    worksheet3->write_string(2, 1, bar, format);
+
+    (void)worksheet2; /* Unused. For testing only. */
+
+    int result = workbook->close(); return result;
+}
@@ -0,0 +1,39 @@
+/*****************************************************************************
+ * Test cases for libxlsxwriter.
+ *
+ * Test case for shared strings ordered by how many cells use them.
+ *
+ * Copyright 2014-2016, John McNamara, jmcnamara@cpan.org
+ *
+ */
+
+#include "xlsxwriter.hpp"
+
+int main() {
+
+    xlsxwriter::workbook_options options;
+    options.order_strings_by_frequency = true;
+
+    std::shared_ptr<xlsxwriter::workbook> workbook  = std::make_shared<xlsxwriter::workbook>("test_shared_strings05.xlsx", options);
+    xlsxwriter::worksheet *worksheet1 = workbook->add_worksheet();
+    xlsxwriter::worksheet *worksheet2 = workbook->add_worksheet("Data Sheet");
+    xlsxwriter::worksheet *worksheet3 = workbook->add_worksheet();
+
+    xlsxwriter::format    *format     = workbook->add_format();
+    format->set_bold();
+
+    /* "Bar" is added to the table first, and "Unused" isn't used by any
+     * cells, but "Foo" is used the most. */
+    xlsxwriter::sst_handle bar = workbook->intern_string("Bar");
+    workbook->intern_string("Unused");
+
+    worksheet3->write_string(2, 1, bar, format);
+    worksheet3->write_string(1, 1, "Foo");
+    worksheet3->write_number(3, 2, 234);
+    worksheet1->write_string(0, 0, "Foo");
+    worksheet1->write_number(1, 0, 123);
+
+    (void)worksheet2; /* Unused. For testing only. */
+
+    int result = workbook->close(); return result;
+}
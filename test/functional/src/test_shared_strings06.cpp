@@ -0,0 +1,133 @@
+/*****************************************************************************
+ * Test cases for libxlsxwriter.
+ *
+ * Test case for a shared string table kept on disk.
+ *
+ * Copyright 2014-2016, John McNamara, jmcnamara@cpan.org
+ *
+ */
+
+#include <stdio.h>
+
+#include "xlsxwriter.hpp"
+
+#include <thread>
+#include <vector>
+
+#define NUM_THREADS 4
+#define NUM_STRINGS 20000
+
+/*
+ * Intern and write repeated strings to an on disk table, from several threads
+ * if it is concurrent. The strings are written straight to tmpfiles and the
+ * repeated strings have to be read back to find them.
+ */
+static int test_disk_sst(bool concurrent)
+{
+    xlsxwriter::workbook_options options;
+    options.disk_shared_strings = true;
+    options.concurrent_strings = concurrent;
+    options.spool_threshold = 0;
+
+    xlsxwriter::workbook *workbook = new xlsxwriter::workbook("test_shared_strings06_big.xlsx", options);
+    std::vector<xlsxwriter::worksheet *> worksheets;
+    std::vector<std::thread> threads;
+    std::vector<int> failures(NUM_THREADS);
+    std::string long_string(32767, 'x');
+    int result = 0;
+    int i;
+
+    for (i = 0; i < NUM_THREADS; i++)
+        worksheets.push_back(workbook->add_worksheet());
+
+    for (i = 0; i < NUM_THREADS; i++) {
+        threads.push_back(std::thread([&, i]() {
+            xlsxwriter::worksheet *worksheet = worksheets[i];
+            std::vector<uint32_t> indices;
+            int j;
+
+            for (j = 0; j < NUM_STRINGS; j++) {
+                std::string string = "String " + std::to_string(j % (NUM_STRINGS / 4));
+                xlsxwriter::sst_handle handle = workbook->intern_string(string);
+
+                if (j < NUM_STRINGS / 4)
+                    indices.push_back(handle.index);
+                else if (indices[j % (NUM_STRINGS / 4)] != handle.index)
+                    failures[i]++;
+
+                if (worksheet->write_string(j, 0, handle, NULL))
+                    failures[i]++;
+            }
+        }));
+
+        /* Strings are only interned from one thread at a time without the
+         * concurrent option. */
+        if (!concurrent)
+            threads.back().join();
+    }
+
+    for (auto& thread : threads) {
+        if (thread.joinable())
+            thread.join();
+    }
+
+    for (i = 0; i < NUM_THREADS; i++)
+        result += failures[i];
+
+    /* Strings that only differ at the end. */
+    for (i = 0; i < 4; i++) {
+        long_string[32766] = 'a' + i;
+
+        if (worksheets[0]->write_string(i, 1, long_string, NULL))
+            result++;
+    }
+
+    long_string[32766] = 'a';
+
+    if (workbook->intern_string(long_string).index
+        != workbook->intern_string(long_string).index)
+        result++;
+
+    if (workbook->close())
+        result++;
+
+    delete workbook;
+    remove("test_shared_strings06_big.xlsx");
+
+    return result;
+}
+
+int main() {
+
+    if (test_disk_sst(false) || test_disk_sst(true))
+        return 1;
+
+    xlsxwriter::workbook_options options;
+    options.disk_shared_strings = true;
+    options.spool_threshold = 0;
+
+    std::shared_ptr<xlsxwriter::workbook> workbook  = std::make_shared<xlsxwriter::workbook>("test_shared_strings06.xlsx", options);
+    xlsxwriter::worksheet *worksheet1 = workbook->add_worksheet();
+    xlsxwriter::worksheet *worksheet2 = workbook->add_worksheet("Data Sheet");
+    xlsxwriter::worksheet *worksheet3 = workbook->add_worksheet();
+
+    xlsxwriter::format    *format     = workbook->add_format();
+    format->set_bold();
+
+    xlsxwriter::sst_handle foo = workbook->intern_string("Foo");
+    xlsxwriter::sst_handle bar = workbook->intern_string("Bar");
+
+    /* Interning again should give the same handle. */
+    if (workbook->intern_string("Foo").index != foo.index)
+        return 1;
+
+    worksheet1->write_string(0, 0, "Foo");
+    worksheet1->write_number(1, 0, 123);
+    worksheet3->write_string(1, 1, foo);
+    worksheet3->write_string(2, 1, bar, format);
+    worksheet3->write_number(3, 2, 234);
+
+    (void)worksheet2; /* Unused. For testing only. */
+
+    int result = workbook->close(); return result;
+}
@@ -0,0 +1,45 @@
+/*****************************************************************************
+ * Test cases for libxlsxwriter.
+ *
+ * Test case for strings interned with workbook::intern_string() that aren't
+ * written to a cell.
+ *
+ * Copyright 2014-2016, John McNamara, jmcnamara@cpan.org
+ *
+ */
+
+#include "xlsxwriter.hpp"
+
+int main() {
+
+    std::shared_ptr<xlsxwriter::workbook> workbook  = std::make_shared<xlsxwriter::workbook>("test_shared_strings07.xlsx");
+    xlsxwriter::worksheet *worksheet1 = workbook->add_worksheet();
+    xlsxwriter::worksheet *worksheet2 = workbook->add_worksheet("Data Sheet");
+    xlsxwriter::worksheet *worksheet3 = workbook->add_worksheet();
+
+    xlsxwriter::format    *format     = workbook->add_format();
+    format->set_bold();
+
+    /* The unused strings shouldn't be written to sharedStrings.xml or move
+     * the strings after them. */
+    xlsxwriter::sst_handle unused = workbook->intern_string("Unused");
+    xlsxwriter::sst_handle foo = workbook->intern_string("Foo");
+    workbook->intern_string("Also unused");
+    xlsxwriter::sst_handle bar = workbook->intern_string("Bar");
+
+    (void)unused; /* Unused. For testing only. */
+
+    worksheet1->write_string(0, 0, foo);
+    worksheet1->write_number(1, 0, 123);
+    worksheet3->write_string(1, 1, foo);
+    worksheet3->write_string(2, 1, bar, format);
+    worksheet3->write_number(3, 2, 234);
+
+    (void)worksheet2; /* Unused. For testing only. */
+
+    /* The numbering is the same for each save. */
+    if (workbook->save("test_shared_strings07.xlsx") != LXW_NO_ERROR)
+        return 1;
+
+    int result = workbook->close(); return result;
+}
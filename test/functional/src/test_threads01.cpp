@@ -0,0 +1,87 @@
+/*****************************************************************************
+ * Test cases for libxlsxwriter.
+ *
+ * Test case for filling the worksheets of a workbook from several threads.
+ * The workbook is also written serially, to compare the output against.
+ *
+ * Copyright 2014-2016, John McNamara, jmcnamara@cpan.org
+ *
+ */
+
+#include "xlsxwriter.hpp"
+
+#include <functional>
+#include <thread>
+#include <vector>
+
+#define NUM_SHEETS 64
+#define NUM_ROWS   200
+
+static void fill_worksheet(xlsxwriter::workbook *workbook,
+                           xlsxwriter::worksheet *worksheet, int sheet) {
+
+    xlsxwriter::format scratch;
+    scratch.set_bold();
+    scratch.set_font_color(0x100000 * (sheet % 8));
+    xlsxwriter::format *heading = workbook->intern_format(xlsxwriter::format_spec(scratch));
+
+    xlsxwriter::format *italic = workbook->add_format();
+    italic->set_italic();
+
+    worksheet->set_column(0, 0, 20, italic);
+    worksheet->write_string(0, 0, "Name", heading);
+    worksheet->write_string(0, 1, "Value", heading);
+    worksheet->write_string(0, 2, "Sheet " + std::to_string(sheet), heading);
+
+    for (int row = 1; row < NUM_ROWS; row++) {
+        worksheet->write_string(row, 0, "Item " + std::to_string(row % 50));
+        worksheet->write_number(row, 1, sheet * 1000 + row);
+        worksheet->write_string(row, 2, "Sheet " + std::to_string(sheet)
+                                + " row " + std::to_string(row), italic);
+    }
+
+    if (sheet % 16 == 0) {
+        xlsxwriter::chart *chart = workbook->add_chart(xlsxwriter::LXW_CHART_COLUMN);
+        chart->add_series("", "=Sheet" + std::to_string(sheet + 1) + "!$B$2:$B$6");
+        worksheet->insert_chart(1, 4, chart);
+    }
+
+    if (sheet == 37)
+        worksheet->activate();
+
+    if (sheet == 30)
+        worksheet->set_first_sheet();
+}
+
+static int write_workbook(const std::string& filename, bool parallel) {
+
+    xlsxwriter::workbook_options options;
+    options.concurrent_strings = true;
+
+    std::shared_ptr<xlsxwriter::workbook> workbook  = std::make_shared<xlsxwriter::workbook>(filename, options);
+    std::vector<xlsxwriter::worksheet *> worksheets;
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < NUM_SHEETS; i++)
+        worksheets.push_back(workbook->add_worksheet());
+
+    for (int i = 0; i < NUM_SHEETS; i++) {
+        if (parallel)
+            threads.push_back(std::thread(fill_worksheet, workbook.get(), worksheets[i], i));
+        else
+            fill_worksheet(workbook.get(), worksheets[i], i);
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    return workbook->close();
+}
+
+int main() {
+
+    if (write_workbook("test_threads01_serial.xlsx", false))
+        return 1;
+
+    int result = write_workbook("test_threads01.xlsx", true); return result;
+}
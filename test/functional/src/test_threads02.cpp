@@ -0,0 +1,98 @@
+/*****************************************************************************
+ * Test cases for libxlsxwriter.
+ *
+ * Test case for filling the row bands of a worksheet from several threads.
+ * The worksheet is also written serially, to compare the output against.
+ *
+ * Copyright 2014-2016, John McNamara, jmcnamara@cpan.org
+ *
+ */
+
+#include "xlsxwriter.hpp"
+
+#include <thread>
+#include <vector>
+
+#define NUM_BANDS 8
+#define NUM_ROWS  2400
+
+/* Write a row to a worksheet or to a worksheet band. */
+template <class T>
+static void write_row(T *sheet, lxw_row_t row, xlsxwriter::format *bold) {
+    sheet->write_string(row, 0, "Item " + std::to_string(row % 97));
+    sheet->write_number(row, 1, row * 1.5);
+    sheet->write_formula(row, 2, "=B" + std::to_string(row + 1) + "*2", NULL);
+    sheet->write_boolean(row, 3, row % 2 == 0);
+
+    if (row % 10 == 0)
+        sheet->write_string(row, 4, "Row " + std::to_string(row), bold);
+}
+
+static int write_workbook(const std::string& filename, bool parallel) {
+
+    std::shared_ptr<xlsxwriter::workbook> workbook  = std::make_shared<xlsxwriter::workbook>(filename);
+    xlsxwriter::worksheet *worksheet = workbook->add_worksheet();
+    xlsxwriter::format    *bold      = workbook->add_format();
+    bold->set_bold();
+
+    /* Cells written to the worksheet directly are kept. */
+    worksheet->write_string(0, 0, "Name");
+    worksheet->write_string(0, 1, "Value");
+    worksheet->set_row(5, 30);
+
+    if (!parallel) {
+        worksheet->write_string(0, 5, "Total");
+        worksheet->write_formula(0, 6, "=SUM(B2:B" + std::to_string(NUM_ROWS) + ")", NULL);
+
+        for (lxw_row_t row = 1; row < NUM_ROWS; row++)
+            write_row(worksheet, row, bold);
+
+        return workbook->close();
+    }
+
+    std::vector<xlsxwriter::worksheet_band *> bands = worksheet->partition(NUM_BANDS, NUM_ROWS / NUM_BANDS);
+    std::vector<std::thread> threads;
+
+    if (bands.size() != NUM_BANDS)
+        return 1;
+
+    /* Writes outside a band are rejected. */
+    if (bands[1]->write_number(0, 0, 1) != LXW_ERROR_WORKSHEET_INDEX_OUT_OF_RANGE)
+        return 1;
+
+    /* The first row of the first band is row 0, which is also in the row
+     * cache of a new band or of a band after a save(). */
+    if (bands[0]->write_string(0, 5, "Total"))
+        return 1;
+
+    if (workbook->save(filename))
+        return 1;
+
+    if (bands[0]->write_formula(0, 6, "=SUM(B2:B" + std::to_string(NUM_ROWS) + ")", NULL))
+        return 1;
+
+    /* Write the bands in reverse order. */
+    for (int i = NUM_BANDS - 1; i >= 0; i--) {
+        xlsxwriter::worksheet_band *band = bands[i];
+
+        threads.push_back(std::thread([band, bold]() {
+            for (lxw_row_t row = band->end_row(); row > band->first_row(); row--) {
+                if (row - 1 > 0)
+                    write_row(band, row - 1, bold);
+            }
+        }));
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    return workbook->close();
+}
+
+int main() {
+
+    if (write_workbook("test_threads02_serial.xlsx", false))
+        return 1;
+
+    int result = write_workbook("test_threads02.xlsx", true); return result;
+}
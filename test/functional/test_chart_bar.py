@@ -16,6 +16,11 @@ class TestCompareXLSXFiles(base_test_class.XLSXBaseTest):
     def test_chart_bar01(self):
         self.run_exe_test('test_chart_bar01')
 
+    def test_chart_data01(self):
+        # Rows in constant_memory mode don't have spans, unlike chart_bar01.
+        self.ignore_elements = {'xl/worksheets/sheet1.xml': ['<row']}
+        self.run_exe_test('test_chart_data01', 'chart_bar01.xlsx')
+
     def test_chart_bar02(self):
         self.run_exe_test('test_chart_bar02')
 
@@ -25,6 +30,9 @@ class TestCompareXLSXFiles(base_test_class.XLSXBaseTest):
     def test_chart_bar04(self):
         self.run_exe_test('test_chart_bar04')
 
+    def test_chart_threads01(self):
+        self.run_exe_test('test_chart_threads01', 'chart_bar04.xlsx')
+
     def test_chart_bar05(self):
         self.run_exe_test('test_chart_bar05')
 
@@ -5,6 +5,9 @@
 # Copyright 2014-2016, John McNamara, jmcnamara@cpan.org
 #
 
+import pytest
+import os
+import zipfile
 import base_test_class
 
 class TestCompareXLSXFiles(base_test_class.XLSXBaseTest):
@@ -15,3 +18,23 @@ class TestCompareXLSXFiles(base_test_class.XLSXBaseTest):
 
     def test_chart_line01(self):
         self.run_exe_test('test_chart_line01')
+
+    def test_chart_points01(self):
+        """Check the data cache of series with more than 65535 points."""
+        exec_dir = pytest.config.getoption('exec_dir')
+        filename = os.path.join(exec_dir, 'test_chart_points01.xlsx')
+
+        got = os.system("cd %s; ./%s" % (exec_dir, 'test_chart_points01'))
+        self.assertEqual(got, self.no_system_error)
+
+        try:
+            with zipfile.ZipFile(filename) as xlsx:
+                chart = xlsx.read('xl/charts/chart1.xml').decode('utf-8')
+        finally:
+            os.remove(filename)
+
+        self.assertEqual(chart.count('<c:ptCount val="70000"/>'), 3)
+        self.assertEqual(chart.count('<c:pt idx="69999">'), 3)
+        self.assertEqual(chart.count('<c:pt idx="1">'), 0)
+        self.assertIn('<c:pt idx="69999"><c:v>Last</c:v></c:pt>', chart)
+        self.assertIn('<c:pt idx="69999"><c:v>139998</c:v></c:pt>', chart)
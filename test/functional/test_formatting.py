@@ -36,3 +36,9 @@ class TestCompareXLSXFiles(base_test_class.XLSXBaseTest):
 
     def test_format12(self):
         self.run_exe_test('test_format12')
+
+    def test_format_hash01(self):
+        self.run_exe_test('test_format_hash01', 'simple01.xlsx')
+
+    def test_format_intern01(self):
+        self.run_exe_test('test_format_intern01', 'format12.xlsx')
@@ -5,6 +5,10 @@
 # Copyright 2014-2016, John McNamara, jmcnamara@cpan.org
 #
 
+import pytest
+import os
+import re
+import zipfile
 import base_test_class
 
 class TestCompareXLSXFiles(base_test_class.XLSXBaseTest):
@@ -17,6 +21,35 @@ class TestCompareXLSXFiles(base_test_class.XLSXBaseTest):
     def test_image01(self):
         self.run_exe_test('test_image01')
 
+    def test_image_buffer01(self):
+        self.run_exe_test('test_image_buffer01', 'image01.xlsx')
+
+    def test_image_dedup01(self):
+        """Check that identical images share one media file."""
+        exec_dir = pytest.config.getoption('exec_dir')
+        filename = os.path.join(exec_dir, 'test_image_dedup01.xlsx')
+
+        got = os.system("cd %s; ./%s" % (exec_dir, 'test_image_dedup01'))
+        self.assertEqual(got, self.no_system_error)
+
+        try:
+            with zipfile.ZipFile(filename) as xlsx:
+                media = sorted(name for name in xlsx.namelist()
+                               if name.startswith('xl/media/'))
+                drawing1 = xlsx.read('xl/drawings/drawing1.xml').decode('utf-8')
+                rels1 = xlsx.read('xl/drawings/_rels/drawing1.xml.rels').decode('utf-8')
+                rels2 = xlsx.read('xl/drawings/_rels/drawing2.xml.rels').decode('utf-8')
+        finally:
+            os.remove(filename)
+
+        self.assertEqual(media, ['xl/media/image1.png', 'xl/media/image2.png'])
+        self.assertEqual(drawing1.count('r:embed="rId1"'), 2)
+        self.assertEqual(drawing1.count('r:embed="rId2"'), 1)
+        self.assertEqual(rels1.count('<Relationship '), 2)
+        self.assertIn('Target="../media/image1.png"', rels1)
+        self.assertIn('Target="../media/image2.png"', rels1)
+        self.assertIn('Target="../media/image1.png"', rels2)
+
     def test_image02(self):
         self.run_exe_test('test_image02')
 
@@ -109,3 +142,78 @@ class TestCompareXLSXFiles(base_test_class.XLSXBaseTest):
 
     def test_image35(self):
         self.run_exe_test('test_image35')
+
+    def test_image36(self):
+        """Check object anchors against the row and column sizes."""
+        exec_dir = pytest.config.getoption('exec_dir')
+        filename = os.path.join(exec_dir, 'test_image36.xlsx')
+
+        got = os.system("cd %s; ./%s" % (exec_dir, 'test_image36'))
+        self.assertEqual(got, self.no_system_error)
+
+        try:
+            with zipfile.ZipFile(filename) as xlsx:
+                drawing = xlsx.read('xl/drawings/drawing1.xml').decode('utf-8')
+        finally:
+            os.remove(filename)
+
+        # The sizes in pixels set up by the test.
+        col_sizes = {0: 40, 1: 40, 2: 40, 3: 145, 4: 145, 5: 145, 6: 145,
+                     7: 145, 8: 145, 10: 0}
+        row_sizes = {2: 40, 6: 33, 9: 11}
+
+        def col_size(col):
+            return col_sizes.get(col, 64)
+
+        def row_size(row):
+            return row_sizes.get(row, 20)
+
+        def position(row, col, x1, y1, width, height):
+            x_abs = sum(col_size(i) for i in range(col)) + x1
+            y_abs = sum(row_size(i) for i in range(row)) + y1
+
+            while x1 >= col_size(col):
+                x1 -= col_size(col)
+                col += 1
+
+            while y1 >= row_size(row):
+                y1 -= row_size(row)
+                row += 1
+
+            col_end, row_end = col, row
+            width += x1
+            height += y1
+
+            while width >= col_size(col_end):
+                width -= col_size(col_end)
+                col_end += 1
+
+            while height >= row_size(row_end):
+                height -= row_size(row_end)
+                row_end += 1
+
+            return ((col, x1 * 9525, row, y1 * 9525),
+                    (col_end, width * 9525, row_end, height * 9525),
+                    (x_abs * 9525, y_abs * 9525))
+
+        anchor = (r'<xdr:col>(\d+)</xdr:col><xdr:colOff>(\d+)</xdr:colOff>'
+                  r'<xdr:row>(\d+)</xdr:row><xdr:rowOff>(\d+)</xdr:rowOff>')
+        images = []
+        charts = []
+
+        for obj in re.findall(r'<xdr:twoCellAnchor.*?</xdr:twoCellAnchor>', drawing):
+            vertices = [tuple(int(n) for n in v) for v in re.findall(anchor, obj)]
+
+            if '<xdr:pic>' in obj:
+                offset = re.search(r'<a:off x="(\d+)" y="(\d+)"/>', obj)
+                vertices.append((int(offset.group(1)), int(offset.group(2))))
+                images.append(tuple(vertices))
+            else:
+                charts.append(tuple(vertices))
+
+        self.assertEqual(images, [position(0, 0, 0, 0, 32, 32),
+                                  position(4, 4, 0, 0, 32, 32),
+                                  position(7, 11, 0, 0, 32, 32),
+                                  position(30, 20, 200, 50, 32, 32),
+                                  position(8, 8, 150, 70, 32, 32)])
+        self.assertEqual(charts, [position(39, 13, 0, 0, 480, 288)[:2]])
@@ -5,6 +5,10 @@
 # Copyright 2014-2016, John McNamara, jmcnamara@cpan.org
 #
 
+import pytest
+import os
+import re
+import zipfile
 import base_test_class
 
 class TestCompareXLSXFiles(base_test_class.XLSXBaseTest):
@@ -27,3 +31,32 @@ class TestCompareXLSXFiles(base_test_class.XLSXBaseTest):
 
     def test_merge_range05(self):
         self.run_exe_test('test_merge_range05')
+
+    def test_merge_range06(self):
+        """Check merged ranges against the same cells written one by one."""
+        exec_dir = pytest.config.getoption('exec_dir')
+        parts = []
+
+        got = os.system("cd %s; ./%s" % (exec_dir, 'test_merge_range06'))
+        self.assertEqual(got, self.no_system_error)
+
+        for name in ('test_merge_range06.xlsx', 'test_merge_range06_ref.xlsx'):
+            filename = os.path.join(exec_dir, name)
+            try:
+                with zipfile.ZipFile(filename) as xlsx:
+                    parts.append([xlsx.read(member).decode('utf-8') for member in
+                                  ('xl/worksheets/sheet1.xml',
+                                   'xl/charts/chart1.xml',
+                                   'xl/sharedStrings.xml')])
+            finally:
+                os.remove(filename)
+
+        (sheet, chart, sst), (ref_sheet, ref_chart, ref_sst) = parts
+        sheet_data = re.search(r'<sheetData>.*</sheetData>', sheet).group(0)
+        ref_sheet_data = re.search(r'<sheetData>.*</sheetData>', ref_sheet).group(0)
+
+        self.assertEqual(sheet_data, ref_sheet_data)
+        self.assertEqual(chart, ref_chart)
+        self.assertEqual(sst, ref_sst)
+        self.assertEqual(re.findall(r'<mergeCell ref="([^"]*)"/>', sheet),
+                         ['B2:D4', 'B11:E13', 'G15:I19', 'C41:D42'])
@@ -27,6 +27,32 @@ class TestCompareXLSXFiles(base_test_class.XLSXBaseTest):
     def test_shared_strings01(self):
         self.run_exe_test('test_shared_strings01')
 
+    def test_shared_strings02(self):
+        self.run_exe_test('test_shared_strings02', 'simple01.xlsx')
+
+    def test_shared_strings03(self):
+        self.run_exe_test('test_shared_strings03', 'simple02.xlsx')
+
+    def test_shared_strings04(self):
+        self.run_exe_test('test_shared_strings04', 'simple02.xlsx')
+
+    def test_shared_strings05(self):
+        self.run_exe_test('test_shared_strings05', 'simple02.xlsx')
+
+    def test_shared_strings06(self):
+        self.run_exe_test('test_shared_strings06', 'simple02.xlsx')
+
+    def test_shared_strings07(self):
+        self.run_exe_test('test_shared_strings07', 'simple02.xlsx')
+
+    def test_inline_strings01(self):
+        # Rows outside of constant_memory mode have spans, unlike optimize01.
+        self.ignore_elements = {'xl/worksheets/sheet1.xml': ['<row']}
+        self.run_exe_test('test_inline_strings01', 'optimize01.xlsx')
+
+    def test_inline_strings02(self):
+        self.run_exe_test('test_inline_strings02', 'simple01.xlsx')
+
     def test_gh42_01(self):
         self.run_exe_test('test_gh42_01')
 
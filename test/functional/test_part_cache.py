@@ -0,0 +1,23 @@
+###############################################################################
+#
+# Tests for libxlsxwriter.
+#
+# Copyright 2014-2016, John McNamara, jmcnamara@cpan.org
+#
+
+import base_test_class
+
+class TestCompareXLSXFiles(base_test_class.XLSXBaseTest):
+    """
+    Test file created with libxlsxwriter against a file created by Excel.
+
+    """
+
+    def test_part_cache01(self):
+        self.run_exe_test('test_part_cache01', 'simple01.xlsx')
+
+    def test_part_cache02(self):
+        self.run_exe_test('test_part_cache02', 'simple01.xlsx')
+
+    def test_part_cache03(self):
+        self.run_exe_test('test_part_cache03', 'simple01.xlsx')
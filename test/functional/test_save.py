@@ -0,0 +1,86 @@
+###############################################################################
+#
+# Tests for libxlsxwriter.
+#
+# Copyright 2014-2016, John McNamara, jmcnamara@cpan.org
+#
+
+import pytest
+import os
+import re
+import zipfile
+import base_test_class
+
+class TestCompareXLSXFiles(base_test_class.XLSXBaseTest):
+    """
+    Test file created with libxlsxwriter against a file created by Excel.
+
+    """
+
+    def test_save01(self):
+        self.run_exe_test('test_save01', 'simple01.xlsx')
+
+    def test_save02(self):
+        self.run_exe_test('test_save02', 'chart_bar01.xlsx')
+
+    def test_save03(self):
+        self.run_exe_test('test_save03', 'image01.xlsx')
+
+    def test_save07(self):
+        self.run_exe_test('test_save07', 'simple03.xlsx')
+
+    def _read_string_cells(self, exe_name):
+        """Run a test and read the string cells of its worksheets."""
+        exec_dir = pytest.config.getoption('exec_dir')
+        filename = os.path.join(exec_dir, exe_name + '.xlsx')
+
+        got = os.system("cd %s; ./%s" % (exec_dir, exe_name))
+        self.assertEqual(got, self.no_system_error)
+
+        try:
+            with zipfile.ZipFile(filename) as xlsx:
+                sst = xlsx.read('xl/sharedStrings.xml').decode('utf-8')
+                sheets = [xlsx.read('xl/worksheets/sheet%d.xml' % i).decode('utf-8')
+                          for i in (1, 2)]
+        finally:
+            os.remove(filename)
+
+        strings = re.findall(r'<t>([^<]*)</t>', sst)
+        cells = []
+
+        for sheet in sheets:
+            cells.append(dict((ref, strings[int(index)]) for ref, index in
+                              re.findall(r'<c r="(\w+)" t="s"><v>(\d+)</v>', sheet)))
+
+        return cells
+
+    def test_save04(self):
+        """Check unchanged worksheets after strings are renumbered by use."""
+        cells = self._read_string_cells('test_save04')
+
+        self.assertEqual(cells[0], {'A1': 'Foo', 'A2': 'Foo', 'A3': 'Foo', 'A4': 'Foo'})
+        self.assertEqual(cells[1], {'A1': 'Bar', 'A2': 'Bar'})
+
+    def test_save05(self):
+        """Check unchanged worksheets after concurrent strings are renumbered."""
+        cells = self._read_string_cells('test_save05')
+
+        self.assertEqual(cells[0], {'A1': 'Foo', 'A2': 'Baz'})
+        self.assertEqual(cells[1], {'A1': 'Bar', 'A2': 'Bar'})
+
+    def test_save06(self):
+        """Check that a chart range is read once its worksheet is added."""
+        exec_dir = pytest.config.getoption('exec_dir')
+        filename = os.path.join(exec_dir, 'test_save06.xlsx')
+
+        got = os.system("cd %s; ./%s" % (exec_dir, 'test_save06'))
+        self.assertEqual(got, self.no_system_error)
+
+        try:
+            with zipfile.ZipFile(filename) as xlsx:
+                chart = xlsx.read('xl/charts/chart1.xml').decode('utf-8')
+        finally:
+            os.remove(filename)
+
+        self.assertIn('<c:ptCount val="3"/>', chart)
+        self.assertEqual(re.findall(r'<c:v>([^<]*)</c:v>', chart), ['10', '20', '30'])
@@ -0,0 +1,36 @@
+###############################################################################
+#
+# Tests for libxlsxwriter.
+#
+# Copyright 2014-2016, John McNamara, jmcnamara@cpan.org
+#
+
+import pytest
+import os
+import base_test_class
+
+class TestCompareXLSXFiles(base_test_class.XLSXBaseTest):
+    """
+    Test file created from several threads against one created serially.
+
+    """
+
+    def run_exe_serial_test(self, exe_name):
+        """Compare the output of the exe with the serial version it wrote."""
+        exec_dir = pytest.config.getoption('exec_dir')
+        # run_exe_test() joins the expected file onto data_dir, which keeps
+        # an absolute path as it is.
+        serial_filename = os.path.abspath(
+            os.path.join(exec_dir, exe_name + '_serial.xlsx'))
+
+        try:
+            self.run_exe_test(exe_name, serial_filename)
+        finally:
+            if os.path.exists(serial_filename):
+                os.remove(serial_filename)
+
+    def test_threads01(self):
+        self.run_exe_serial_test('test_threads01')
+
+    def test_threads02(self):
+        self.run_exe_serial_test('test_threads02')
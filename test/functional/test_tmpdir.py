@@ -18,3 +18,9 @@ class TestCompareXLSXFiles(base_test_class.XLSXBaseTest):
 
     def test_tmpdir02(self):
         self.run_exe_test('test_tmpdir02', 'optimize01.xlsx')
+
+    def test_tmpdir03(self):
+        self.run_exe_test('test_tmpdir03', 'simple01.xlsx')
+
+    def test_tmpdir04(self):
+        self.run_exe_test('test_tmpdir04', 'optimize01.xlsx')